@@ -28,10 +28,15 @@ int main(int argc, char **argv) {
     CliInput cliInput;
     try {
         cliInput.addArgument(InputArgument("i", ArgumentType::String, "Path to source encoded data", true));
-        cliInput.addArgument(InputArgument("o", ArgumentType::String, "Destination output folder", true));
+        cliInput.addArgument(InputArgument("o", ArgumentType::String, "Destination output folder, or output file if directions are given", true));
         cliInput.addArgument(InputArgument("format", ArgumentType::String, "Image format to output to. (png, bmp, tga, jpg, hdr)", false, "png"));
         cliInput.addArgument(InputArgument("size", ArgumentType::Integer, "Resolution of generated cubemap images", false, "64"));
         cliInput.addArgument(InputArgument("prefix", ArgumentType::String, "String prefix will be added to the filename. Default: empty string", false, ""));
+        cliInput.addArgument(InputArgument("directions", ArgumentType::String, "Path to binary file of float32 (x, y, z) unit directions. If set, signal is decoded at these directions and written to output file as float32 (r, g, b[, a]) instead of cubemap", false, ""));
+        cliInput.addArgument(InputArgument("threads", ArgumentType::Integer, "Amount of threads decoding directions. Default: hardware concurrency", false, "0"));
+        cliInput.addArgument(InputArgument("mips", ArgumentType::Integer, "Write specular prefiltered mip chain of given amount of levels, roughness goes from 0 to 1 across levels. Default: single level without filtering", false, "0"));
+        cliInput.addArgument(InputArgument("planar", ArgumentType::Boolean, "Decode every channel of the file whatever its name, each channel is written as single channel images named '<prefix><channel>-<face>'", false, "false"));
+        cliInput.addArgument(InputArgument("hemisphere", ArgumentType::Boolean, "Data is encoded with hemispherical harmonics (encode 'hemisphere' 'hsh'), texels and directions below the horizon are decoded as zero. Default: told by \"basis\" of the file", false, "false"));
         cliInput.addArgument(InputArgument("alpha", ArgumentType::Boolean, "Load images in rgba format. Default: loading happens ignoring alpha channel", false, "false"));
 
         string commandLine;
@@ -51,14 +56,73 @@ int main(int argc, char **argv) {
         const string prefix = arguments["prefix"].value.asString;
         const bool alpha = arguments["alpha"].value.asBoolean;
 
-        if (alpha) {
+        const string directionsPath = arguments["directions"].value.asString;
+        const auto threads = (unsigned) std::max(0, arguments["threads"].value.asInteger);
+        const int mips = arguments["mips"].value.asInteger;
+
+        // files of hemispherical harmonics are marked, flag serves data written without the mark
+        if (arguments["hemisphere"].value.asBoolean || (!arguments["planar"].value.asBoolean &&
+                                                        readBasis(input) == Basis::Hemispherical)) {
+            if (alpha || mips > 0 || arguments["planar"].value.asBoolean) {
+                throw string("Hemispherical harmonics don't combine with 'alpha', 'mips' or 'planar'");
+            }
+            const ShCoefficients<RGB> coefficients = readHemispherical(input);
+            if (!directionsPath.empty()) {
+                const vector<vec3> directions = readDirections(directionsPath);
+                vector<RGB> values(directions.size());
+                for (size_t i = 0; i < directions.size(); i++) {
+                    values[i] = decodeHemisphere(coefficients, directions[i]);
+                }
+                writeBinary(output, values);
+            } else {
+                write(output, format, decodeHemisphere<RGB, RGBF>(coefficients, size), prefix);
+            }
+        } else if (arguments["planar"].value.asBoolean) {
+            vector<string> names;
+            const PlanarCoefficients coefficients = readPlanar(input, names);
+            write(output, format, decodeChannels(coefficients, size), names, prefix);
+        } else if (!directionsPath.empty()) {
+            const vector<vec3> directions = readDirections(directionsPath);
+            if (alpha) {
+                const ShCoefficients<RGBA> coefficients = readRgba(input);
+                vector<RGBA> values(directions.size());
+                decode(coefficients, directions.data(), directions.size(), values.data(), threads);
+                writeBinary(output, values);
+            } else {
+                const ShCoefficients<RGB> coefficients = readRgb(input);
+                vector<RGB> values(directions.size());
+                decode(coefficients, directions.data(), directions.size(), values.data(), threads);
+                writeBinary(output, values);
+            }
+        } else if (mips > 0) {
+            if (alpha) {
+                const ShCoefficients<RGBA> coefficients = readRgba(input);
+                const auto chain = prefilter<RGBA, RGBAF>(coefficients, size, (uint16_t) mips);
+                for (size_t level = 0; level < chain.size(); level++) {
+                    write(output, format, chain[level], prefix + "mip" + to_string(level) + "-");
+                }
+            } else {
+                const ShCoefficients<RGB> coefficients = readRgb(input);
+                const auto chain = prefilter<RGB, RGBF>(coefficients, size, (uint16_t) mips);
+                for (size_t level = 0; level < chain.size(); level++) {
+                    write(output, format, chain[level], prefix + "mip" + to_string(level) + "-");
+                }
+            }
+        } else if (alpha) {
             const ShCoefficients<RGBA> coefficients = readRgba(input);
             auto cubemap = decode<RGBA, RGBAF>(coefficients, size);
             write(output, format, cubemap, prefix);
         } else {
-            const ShCoefficients<RGB> coefficients = readRgb(input);
-            auto cubemap = decode<RGB, RGBF>(coefficients, size);
-            write(output, format, cubemap, prefix);
+            // channels of own orders are decoded each up to its order
+            const ColorCoefficients coefficients = readColor(input);
+            const auto &channels = coefficients.channels;
+            if (coefficients.space != ColorSpace::Rgb || channels[0].size() != channels[1].size() ||
+                channels[0].size() != channels[2].size()) {
+                write(output, format, decode<RGBF>(coefficients, size), prefix);
+            } else {
+                auto cubemap = decode<RGB, RGBF>(combine(coefficients), size);
+                write(output, format, cubemap, prefix);
+            }
         }
     } catch (std::string &e) {
         cout << e << endl;
@@ -0,0 +1,3 @@
+@echo off
+
+start ../decode.exe  --i './sh-rgb.json' --o './radiance.bin' --directions './directions.bin' --threads '4'
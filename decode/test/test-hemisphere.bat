@@ -0,0 +1,6 @@
+@echo off
+
+start /wait ../decode.exe  --i './sh-hsh.json' --o './test-write' --prefix='hsh-' --format='png' --size '64' --hemisphere
+
+rem marked data is told by its "basis" field
+start ../decode.exe  --i './sh-hsh.json' --o './test-write' --prefix='hsh-marked-' --format='png' --size '64'
\ No newline at end of file
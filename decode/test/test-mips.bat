@@ -0,0 +1,3 @@
+@echo off
+
+start ../decode.exe  --i './sh-rgb.json' --o './test-write' --prefix='specular-' --format='hdr' --size '128' --mips '6'
@@ -0,0 +1,3 @@
+@echo off
+
+start ../decode.exe  --i './sh-layers.json' --o './test-write' --prefix='planar-' --format='hdr' --size '64' --planar
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <cmath>
 
 #include <glm/glm.hpp>
 
@@ -11,6 +15,108 @@ using namespace sh;
 using namespace sh::math;
 using namespace sh::input;
 
+/**
+ * Split comma separated list
+ * @param list
+ * @return non empty items
+ */
+vector<string> split(const string &list) {
+    vector<string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        const auto comma = std::min(list.find(',', start), list.size());
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+    return items;
+}
+
+/**
+ * Parse number of a value, the whole text has to be a number
+ * @param text
+ * @param spec value the number belongs to, for error message
+ * @return
+ */
+real parseReal(const string &text, const string &spec) {
+    size_t end = 0;
+    real value = 0;
+    try {
+        value = (real) stod(text, &end);
+    } catch (const logic_error &) {
+        end = 0;
+    }
+    if (end == 0 || end != text.size()) {
+        throw string("Number expected in: '"s + spec + "'"s);
+    }
+    return value;
+}
+
+/**
+ * Parse band order of a value
+ * @param text
+ * @param spec value the order belongs to, for error message
+ * @return
+ */
+uint16_t parseOrder(const string &text, const string &spec) {
+    const real value = parseReal(text, spec);
+    if (value < 0 || value > UINT16_MAX || value != std::floor(value)) {
+        throw string("Order has to be a whole number from 0, got: '"s + spec + "'"s);
+    }
+    return (uint16_t) value;
+}
+
+/**
+ * Parse kernel given as 'name' or 'name:parameter'
+ * @param spec
+ * @param order
+ * @return per band factors
+ */
+vector<real> parseKernel(const string &spec, uint16_t order) {
+    const auto colon = spec.find(':');
+    const string name = spec.substr(0, colon);
+    const real parameter = colon == string::npos ? 0 : parseReal(spec.substr(colon + 1), spec);
+    if (name == "cosine"s) {
+        return kernel::cosine(order);
+    } else if (name == "phong"s) {
+        return kernel::phong(order, parameter);
+    } else if (name == "gaussian"s) {
+        return kernel::gaussian(order, parameter);
+    } else if (name == "ggx"s) {
+        return kernel::ggx(order, parameter);
+    }
+    throw string("Unknown convolution kernel: '"s + spec + "'"s);
+}
+
+/**
+ * Parse order criterion given as 'energy:<fraction>' or 'error:<rms error>'
+ * @param spec
+ * @param measure solid angle rms error is taken over
+ * @return order chooser taking energy of bands
+ */
+function<uint16_t(const vector<real> &)> parseCriterion(const string &spec, real measure) {
+    const auto colon = spec.find(':');
+    const string name = spec.substr(0, colon);
+    if (colon == string::npos) {
+        throw string("Order criterion needs a value: '"s + spec + "'"s);
+    }
+    const real parameter = parseReal(spec.substr(colon + 1), spec);
+    if (name == "energy"s) {
+        if (parameter < 0 || parameter > 1) {
+            throw string("Energy fraction has to be from 0 to 1: '"s + spec + "'"s);
+        }
+        return [parameter](const vector<real> &energy) { return orderForEnergy(energy, parameter); };
+    } else if (name == "error"s) {
+        if (parameter < 0) {
+            throw string("Error can't be negative: '"s + spec + "'"s);
+        }
+        return [parameter, measure](const vector<real> &energy) {
+            return orderForError(energy, parameter, measure);
+        };
+    }
+    throw string("Unknown order criterion: '"s + spec + "'"s);
+}
 
 int main(int argc, char **argv) {
 
@@ -20,15 +126,29 @@ int main(int argc, char **argv) {
     CliInput cliInput;
     try {
         cliInput.addArgument(InputArgument("o", ArgumentType::String, "Output filename path", true));
-        cliInput.addArgument(InputArgument("px", ArgumentType::String, "Path to source cubemap POSITIVE X face texture", true));
-        cliInput.addArgument(InputArgument("nx", ArgumentType::String, "Path to source cubemap NEGATIVE X face texture", true));
-        cliInput.addArgument(InputArgument("py", ArgumentType::String, "Path to source cubemap POSITIVE Y face texture", true));
-        cliInput.addArgument(InputArgument("ny", ArgumentType::String, "Path to source cubemap NEGATIVE Y face texture", true));
-        cliInput.addArgument(InputArgument("pz", ArgumentType::String, "Path to source cubemap POSITIVE Z face texture", true));
-        cliInput.addArgument(InputArgument("nz", ArgumentType::String, "Path to source cubemap NEGATIVE Z face texture", true));
+        cliInput.addArgument(InputArgument("px", ArgumentType::String, "Path to source cubemap POSITIVE X face texture. Required unless 'layers' are given", false, ""));
+        cliInput.addArgument(InputArgument("nx", ArgumentType::String, "Path to source cubemap NEGATIVE X face texture. Required unless 'layers' are given", false, ""));
+        cliInput.addArgument(InputArgument("py", ArgumentType::String, "Path to source cubemap POSITIVE Y face texture. Required unless 'layers' are given", false, ""));
+        cliInput.addArgument(InputArgument("ny", ArgumentType::String, "Path to source cubemap NEGATIVE Y face texture. Required unless 'layers' are given", false, ""));
+        cliInput.addArgument(InputArgument("pz", ArgumentType::String, "Path to source cubemap POSITIVE Z face texture. Required unless 'layers' are given", false, ""));
+        cliInput.addArgument(InputArgument("nz", ArgumentType::String, "Path to source cubemap NEGATIVE Z face texture. Required unless 'layers' are given", false, ""));
         cliInput.addArgument(InputArgument("order", ArgumentType::Integer, "The order of spherical harmonics (positive number from 0)", false, "2"));
         cliInput.addArgument(InputArgument("samples", ArgumentType::Integer, "Number of samples to estimate", false, "64"));
-        cliInput.addArgument(InputArgument("method", ArgumentType::String, "Algorithm used for estimating spherical harmonics. Possible values: 'spherical' 'monte-carlo' 'cubemap'", false, "monte-carlo"));
+        cliInput.addArgument(InputArgument("method", ArgumentType::String, "Algorithm used for estimating spherical harmonics. Possible values: 'spherical' 'monte-carlo' 'cubemap' 'quadrature' 'sobol' 'importance' 'control-variate'", false, "monte-carlo"));
+        cliInput.addArgument(InputArgument("tolerance", ArgumentType::Float, "Max standard error of any coefficient, 'sobol' method stops sampling once reached. Sample budget is limited by 'samples'", false, "0.1"));
+        cliInput.addArgument(InputArgument("error", ArgumentType::String, "Path to write per-coefficient standard error to ('sobol' method only). Default: not written", false, ""));
+        cliInput.addArgument(InputArgument("sun", ArgumentType::Boolean, "Extract small bright lobes (sun) and project them analytically, the rest is encoded with given method", false, "false"));
+        cliInput.addArgument(InputArgument("sun-threshold", ArgumentType::Float, "Luminance relative to the average luminance of the environment texel has to exceed to be a part of the sun", false, "20"));
+        cliInput.addArgument(InputArgument("mip", ArgumentType::Integer, "How many times the residual cubemap is downsampled before encoding ('sun' only)", false, "0"));
+        cliInput.addArgument(InputArgument("convolve", ArgumentType::String, "Convolve encoded signal with zonal kernel. Possible values: 'cosine' (irradiance) 'phong:<exponent>' 'gaussian:<width in radians>' 'ggx:<roughness>'. Default: none", false, ""));
+        cliInput.addArgument(InputArgument("extend", ArgumentType::String, "Path to encoded data of lower order. Bands all its channels hold are kept, only bands above up to 'order' are projected from the cubemap ('cubemap' method), not with 'convolve'. New bands are weighted at texel centers rather than by texel integrals, so they differ slightly from a full 'cubemap' encode. Default: none", false, ""));
+        cliInput.addArgument(InputArgument("layers", ArgumentType::String, "Comma separated face path patterns with '{face}' placeholder (posx, negx, ...), e.g. './albedo/{face}.png,./visibility/{face}.hdr'. All channels of all layers are encoded ('cubemap' method), only 'order', 'adaptive' and 'names' apply. Default: none", false, ""));
+        cliInput.addArgument(InputArgument("names", ArgumentType::String, "Comma separated names of channels encoded from 'layers'. Default: 'channel<index>'", false, ""));
+        cliInput.addArgument(InputArgument("space", ArgumentType::String, "Color space channels are stored in. Possible values: 'rgb' 'ycocg'", false, "rgb"));
+        cliInput.addArgument(InputArgument("orders", ArgumentType::String, "Comma separated order of every channel of 'space', e.g. '6,2,2' for luma at 6 and chroma at 2. Signal is encoded at the highest of them. Default: 'order' for all channels", false, ""));
+        cliInput.addArgument(InputArgument("adaptive", ArgumentType::String, "Choose the lowest order up to 'order' meeting criterion, chosen order is written with the data. Possible values: 'energy:<fraction of energy kept>' 'error:<rms error over the sphere, hemisphere for hsh>'. Default: 'order' as is", false, ""));
+        cliInput.addArgument(InputArgument("hemisphere", ArgumentType::String, "Encode upper hemisphere only ('cubemap' method): 'mask' projects onto spherical harmonics skipping texels below the horizon, 'hsh' projects onto hemispherical harmonics, marked with \"basis\": \"hsh\". Not with 'sun', 'extend', 'rows', 'samples', 'filtering'. Default: whole sphere", false, ""));
+        cliInput.addArgument(InputArgument("rows", ArgumentType::Integer, "Encode by steps of given amount of face rows as a renderer spreads encoding over frames ('cubemap' method, faces small enough for integral tables). Default: 0, whole cubemap at once", false, "0"));
         cliInput.addArgument(InputArgument("filtering", ArgumentType::String, "Texture sample filtering, Possible values: 'linear' 'nearest'", false, "linear"));
 
         string commandLine;
@@ -38,7 +158,7 @@ int main(int argc, char **argv) {
 
         ArgumentMap arguments = cliInput.parse(commandLine);
         const string output = arguments["o"].value.asString;
-        const int order = arguments["order"].value.asInteger;
+        int order = arguments["order"].value.asInteger;
         const int samples = arguments["samples"].value.asInteger;
 
         SamplingMethod method;
@@ -48,6 +168,14 @@ int main(int argc, char **argv) {
             method = SamplingMethod::Sphere;
         } else if (arguments["method"].value.asString == "cubemap"s) {
             method = SamplingMethod::Cubemap;
+        } else if (arguments["method"].value.asString == "quadrature"s) {
+            method = SamplingMethod::Quadrature;
+        } else if (arguments["method"].value.asString == "sobol"s) {
+            method = SamplingMethod::Sobol;
+        } else if (arguments["method"].value.asString == "importance"s) {
+            method = SamplingMethod::Importance;
+        } else if (arguments["method"].value.asString == "control-variate"s) {
+            method = SamplingMethod::ControlVariate;
         } else {
             throw string("Unknown sampling method: '"s + arguments["method"].value.asString + "'"s);
         }
@@ -61,6 +189,27 @@ int main(int argc, char **argv) {
             throw string("Unknown filtering: '"s + arguments["filtering"].value.asString + "'"s);
         }
 
+        ColorSpace space;
+        if (arguments["space"].value.asString == "rgb"s) {
+            space = ColorSpace::Rgb;
+        } else if (arguments["space"].value.asString == "ycocg"s) {
+            space = ColorSpace::YCoCg;
+        } else {
+            throw string("Unknown color space: '"s + arguments["space"].value.asString + "'"s);
+        }
+
+        const vector<string> orderList = split(arguments["orders"].value.asString);
+        if (!orderList.empty() && orderList.size() != 3) {
+            throw string("Three channel orders are expected, got: '"s + arguments["orders"].value.asString + "'"s);
+        }
+        array<uint16_t, 3> orders;
+        for (size_t c = 0; c < 3; c++) {
+            orders[c] = orderList.empty() ? (uint16_t) order : parseOrder(orderList[c], orderList[c]);
+        }
+        if (!orderList.empty()) {
+            order = *std::max_element(orders.begin(), orders.end());
+        }
+
         const string px = arguments["px"].value.asString;
         const string nx = arguments["nx"].value.asString;
         const string py = arguments["py"].value.asString;
@@ -68,10 +217,161 @@ int main(int argc, char **argv) {
         const string pz = arguments["pz"].value.asString;
         const string nz = arguments["nz"].value.asString;
 
+        const string convolution = arguments["convolve"].value.asString;
+        vector<real> factors;
+        if (!convolution.empty()) {
+            factors = parseKernel(convolution, (uint16_t) order);
+        }
+        auto convolved = [&factors](const ShCoefficients<RGB> &coefficients) {
+            return factors.empty() ? coefficients : convolve(coefficients, factors);
+        };
+        const string hemisphere = arguments["hemisphere"].value.asString;
+        function<uint16_t(const vector<real> &)> criterion;
+        const string adaptive = arguments["adaptive"].value.asString;
+        if (!adaptive.empty()) {
+            // hemispherical harmonics are orthonormal over the upper hemisphere
+            criterion = parseCriterion(adaptive, hemisphere == "hsh"s ? math::PI2 : math::PI4);
+        }
+        auto chosen = [&criterion](const vector<real> &energy) {
+            const uint16_t order = criterion(energy);
+            cout << "Order chosen: " << order << endl;
+            return order;
+        };
+
+        const bool separated = space != ColorSpace::Rgb || !orderList.empty();
+        auto writeColor = [&](const ShCoefficients<RGB> &coefficients, Basis basis = Basis::Spherical) {
+            ShCoefficients<RGB> result = convolved(coefficients);
+            array<uint16_t, 3> kept = orders;
+            if (criterion) {
+                const uint16_t order = chosen(bandEnergy(result));
+                result = truncate(result, order);
+                for (auto &channelOrder : kept) {
+                    channelOrder = std::min(channelOrder, order);
+                }
+            }
+            if (separated) {
+                write(output, separate(result, space, kept));
+            } else {
+                write(output, result, basis);
+            }
+        };
+
+        const string extension = arguments["extend"].value.asString;
+        const int rows = arguments["rows"].value.asInteger;
+        if (rows < 0) {
+            throw string("Amount of rows per step has to be positive, got: "s + to_string(rows));
+        }
+        const string layers = arguments["layers"].value.asString;
+        if (!layers.empty()) {
+            // the default method stands for 'cubemap' here, as it can't be told from the one given explicitly
+            if ((method != SamplingMethod::Cubemap && method != SamplingMethod::MonteCarlo) || !factors.empty() ||
+                arguments["sun"].value.asBoolean || separated || !hemisphere.empty() || !extension.empty() || rows) {
+                throw string("'layers' are encoded with 'cubemap' method only and don't combine with 'convolve', "
+                             "'sun', 'space', 'orders', 'hemisphere', 'extend' or 'rows'");
+            }
+            const MultiChannelCubeMap cubemap = loadCubemapLayers(split(layers));
+            cout << "Channels: " << cubemap.getChannels() << endl;
+            PlanarCoefficients coefficients = projectChannels(cubemap, (uint16_t) order);
+            if (criterion) {
+                coefficients = planar::truncate(coefficients, chosen(bandEnergy(coefficients)));
+            }
+            write(output, coefficients, split(arguments["names"].value.asString));
+            return 0;
+        }
+        if (px.empty() || nx.empty() || py.empty() || ny.empty() || pz.empty() || nz.empty()) {
+            throw string("Faces 'px', 'nx', 'py', 'ny', 'pz', 'nz' are required unless 'layers' are given");
+        }
+
+        // sample count and filtering can't be told from defaults given explicitly, so only other values are refused
+        if (!hemisphere.empty() && ((method != SamplingMethod::Cubemap && method != SamplingMethod::MonteCarlo) ||
+                                    arguments["sun"].value.asBoolean || !extension.empty() || rows ||
+                                    samples != 64 || filtering != InterpolationMethod::Bilinear)) {
+            throw string("'hemisphere' is encoded with 'cubemap' method only and doesn't combine with 'sun', "
+                         "'extend', 'rows', 'samples' or 'filtering'");
+        }
         auto cubeMap = loadCubemapRgb(px, nx, py, ny, pz, nz);
-        ShCoefficients<RGB> shCoefficients = encode<RGB>(cubeMap, (uint16_t) order, method, (uint16_t) samples, filtering);
+        // zero and constant tiles are found once, when faces are loaded
+        const shared_ptr<const TileMap<RGBF>> tiles = method == SamplingMethod::Cubemap && cubeMap->isSquare() ?
+                make_shared<const TileMap<RGBF>>(*cubeMap) : nullptr;
+        if (hemisphere == "mask"s) {
+            writeColor(projectHemisphere<RGB>(*cubeMap, (uint16_t) order));
+        } else if (hemisphere == "hsh"s) {
+            if (!factors.empty()) {
+                throw string("Zonal convolution doesn't apply to hemispherical harmonics");
+            }
+            if (separated) {
+                throw string("Hemispherical harmonics are written in 'rgb' space at one order only");
+            }
+            writeColor(projectHemisphericalHarmonics<RGB>(*cubeMap, (uint16_t) order), Basis::Hemispherical);
+        } else if (!hemisphere.empty()) {
+            throw string("Unknown hemisphere mode: '"s + hemisphere + "'"s);
+        } else if (!extension.empty()) {
+            if (!factors.empty()) {
+                throw string("Convolution doesn't combine with 'extend': kept bands may be convolved already");
+            }
+            // bands some channel misses are projected anew rather than kept as zero
+            const ColorCoefficients stored = readColor(extension);
+            const uint16_t common = stored.getCommonOrder();
+            const ShCoefficients<RGB> existing = truncate(combine(stored), common);
+            cout << "Bands kept: " << common + 1 << endl;
+            writeColor(extend<RGB>(existing, *cubeMap, (uint16_t) order));
+        } else if (rows) {
+            if ((method != SamplingMethod::Cubemap && method != SamplingMethod::MonteCarlo) ||
+                arguments["sun"].value.asBoolean) {
+                throw string("'rows' are encoded with 'cubemap' method only and don't combine with 'sun'");
+            }
+            if (!cubeMap->isSquare()) {
+                throw string("'rows' need square faces of the same size");
+            }
+            RealtimeEncoder<RGB, RGBF> encoder(cubeMap->getWidth(), (uint16_t) order);
+            const RGBF *faces[6];
+            for (auto &item : faceTransforms()) {
+                faces[item.first] = (*cubeMap)[item.first]->getData();
+            }
+            encoder.begin(faces);
+            int steps = 1;
+            while (!encoder.step(rows)) {
+                steps++;
+            }
+            cout << "Steps taken: " << steps << endl;
+            writeColor(ShCoefficients<RGB>(encoder.coefficients(), encoder.coefficients() + encoder.getCount()));
+        } else if (arguments["sun"].value.asBoolean) {
+            const real threshold = arguments["sun-threshold"].value.asFloat;
+            const int mip = arguments["mip"].value.asInteger;
+            vector<Hotspot<RGB>> hotspots;
+            ShCoefficients<RGB> shCoefficients = encodeHotspots<RGB>(cubeMap, (uint16_t) order, method,
+                    (uint16_t) samples, filtering, threshold, (uint16_t) mip, &hotspots);
 
-        write(output, shCoefficients);
+            for (auto &hotspot : hotspots) {
+                cout << "Hotspot: direction (" << hotspot.direction.x << ", " << hotspot.direction.y << ", "
+                     << hotspot.direction.z << "), radiance (" << hotspot.radiance.r << ", " << hotspot.radiance.g
+                     << ", " << hotspot.radiance.b << "), angle " << hotspot.angle << endl;
+            }
+            writeColor(shCoefficients);
+        } else if (method == SamplingMethod::Sobol) {
+            const real tolerance = arguments["tolerance"].value.asFloat;
+            const string error = arguments["error"].value.asString;
+            ProgressiveEstimate<RGB> estimate = encodeProgressive<RGB>(cubeMap, (uint16_t) order, tolerance,
+                    (uint32_t) samples, filtering);
+
+            cout << "Samples taken: " << estimate.samples << endl;
+            for (int l = 0; l <= order; l++) {
+                real bandError = 0;
+                for (int m = -l; m <= l; m++) {
+                    bandError = std::max(bandError, maxComponent(estimate.error[l * (l + 1) + m]));
+                }
+                cout << "Band " << l << " max standard error: " << bandError << endl;
+            }
+
+            writeColor(estimate.coefficients);
+            if (!error.empty()) {
+                write(error, estimate.error);
+            }
+        } else {
+            ShCoefficients<RGB> shCoefficients = encode<RGB>(cubeMap, (uint16_t) order, method, (uint16_t) samples,
+                    filtering, tiles.get());
+            writeColor(shCoefficients);
+        }
     }
     catch (std::string &e) {
         cout << e << endl;
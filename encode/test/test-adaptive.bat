@@ -0,0 +1,12 @@
+@echo off
+
+start ../encode.exe  --o './sh-adaptive.json' ^
+    --px './assets/cubemap-128x128/posx.jpg' ^
+    --nx './assets/cubemap-128x128/negx.jpg' ^
+    --py './assets/cubemap-128x128/posy.jpg' ^
+    --ny './assets/cubemap-128x128/negy.jpg' ^
+    --pz './assets/cubemap-128x128/posz.jpg' ^
+    --nz './assets/cubemap-128x128/negz.jpg' ^
+    --order='8' ^
+    --method 'cubemap' ^
+    --adaptive 'energy:0.99'
\ No newline at end of file
@@ -0,0 +1,36 @@
+@echo off
+
+start /wait ../encode.exe  --o './sh-order-2.json' ^
+    --px './assets/cubemap-128x128/posx.jpg' ^
+    --nx './assets/cubemap-128x128/negx.jpg' ^
+    --py './assets/cubemap-128x128/posy.jpg' ^
+    --ny './assets/cubemap-128x128/negy.jpg' ^
+    --pz './assets/cubemap-128x128/posz.jpg' ^
+    --nz './assets/cubemap-128x128/negz.jpg' ^
+    --order='2' ^
+    --method 'cubemap'
+
+rem extending has to take less time than the full encode of the same order
+echo Full encode start: %TIME%
+start /wait ../encode.exe  --o './sh-order-6.json' ^
+    --px './assets/cubemap-128x128/posx.jpg' ^
+    --nx './assets/cubemap-128x128/negx.jpg' ^
+    --py './assets/cubemap-128x128/posy.jpg' ^
+    --ny './assets/cubemap-128x128/negy.jpg' ^
+    --pz './assets/cubemap-128x128/posz.jpg' ^
+    --nz './assets/cubemap-128x128/negz.jpg' ^
+    --order='6' ^
+    --method 'cubemap'
+
+echo Extend start: %TIME%
+start /wait ../encode.exe  --o './sh-extended.json' ^
+    --px './assets/cubemap-128x128/posx.jpg' ^
+    --nx './assets/cubemap-128x128/negx.jpg' ^
+    --py './assets/cubemap-128x128/posy.jpg' ^
+    --ny './assets/cubemap-128x128/negy.jpg' ^
+    --pz './assets/cubemap-128x128/posz.jpg' ^
+    --nz './assets/cubemap-128x128/negz.jpg' ^
+    --order='6' ^
+    --method 'cubemap' ^
+    --extend './sh-order-2.json'
+echo Extend end: %TIME%
\ No newline at end of file
@@ -0,0 +1,12 @@
+@echo off
+
+start ../encode.exe  --o './sh-importance.json' ^
+    --px './assets/cubemap/posx.jpg' ^
+    --nx './assets/cubemap/negx.jpg' ^
+    --py './assets/cubemap/posy.jpg' ^
+    --ny './assets/cubemap/negy.jpg' ^
+    --pz './assets/cubemap/posz.jpg' ^
+    --nz './assets/cubemap/negz.jpg' ^
+    --order='6' ^
+    --samples='24000' ^
+    --method 'importance'
@@ -0,0 +1,13 @@
+@echo off
+
+start ../encode.exe  --o './sh-irradiance.json' ^
+    --px './assets/cubemap/posx.jpg' ^
+    --nx './assets/cubemap/negx.jpg' ^
+    --py './assets/cubemap/posy.jpg' ^
+    --ny './assets/cubemap/negy.jpg' ^
+    --pz './assets/cubemap/posz.jpg' ^
+    --nz './assets/cubemap/negz.jpg' ^
+    --order='2' ^
+    --samples='24000' ^
+    --method 'cubemap' ^
+    --convolve 'cosine'
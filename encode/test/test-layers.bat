@@ -0,0 +1,6 @@
+@echo off
+
+start ../encode.exe  --o './sh-layers.json' ^
+    --layers './assets/cubemap-128x128/{face}.jpg,./assets/cubemap-128x128/{face}.jpg' ^
+    --names 'red,green,blue,red2,green2,blue2' ^
+    --order='4'
\ No newline at end of file
@@ -0,0 +1,15 @@
+@echo off
+
+start ../encode.exe  --o './sh-sobol-linear.json' ^
+    --px './assets/cubemap/posx.jpg' ^
+    --nx './assets/cubemap/negx.jpg' ^
+    --py './assets/cubemap/posy.jpg' ^
+    --ny './assets/cubemap/negy.jpg' ^
+    --pz './assets/cubemap/posz.jpg' ^
+    --nz './assets/cubemap/negz.jpg' ^
+    --order='6' ^
+    --samples='1000000' ^
+    --tolerance='0.05' ^
+    --error='./sh-sobol-linear-error.json' ^
+    --method 'sobol' ^
+    --filtering 'linear'
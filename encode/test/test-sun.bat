@@ -0,0 +1,15 @@
+@echo off
+
+start ../encode.exe  --o './sh-sun.json' ^
+    --px './assets/cubemap/posx.jpg' ^
+    --nx './assets/cubemap/negx.jpg' ^
+    --py './assets/cubemap/posy.jpg' ^
+    --ny './assets/cubemap/negy.jpg' ^
+    --pz './assets/cubemap/posz.jpg' ^
+    --nz './assets/cubemap/negz.jpg' ^
+    --order='6' ^
+    --samples='2000' ^
+    --method 'monte-carlo' ^
+    --sun ^
+    --sun-threshold='20' ^
+    --mip='2'
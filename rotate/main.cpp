@@ -0,0 +1,72 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include <sh.h>
+
+using namespace std;
+using namespace sh;
+using namespace sh::math;
+using namespace sh::input;
+
+
+/**
+ * Rotation by yaw around y, then pitch around x, then roll around z (applied to the signal in reverse order)
+ * @param yaw radians
+ * @param pitch radians
+ * @param roll radians
+ * @return
+ */
+mat3 eulerRotation(real yaw, real pitch, real roll) {
+    const mat3 y(vec3(cos(yaw), 0, -sin(yaw)), vec3(0, 1, 0), vec3(sin(yaw), 0, cos(yaw)));
+    const mat3 x(vec3(1, 0, 0), vec3(0, cos(pitch), sin(pitch)), vec3(0, -sin(pitch), cos(pitch)));
+    const mat3 z(vec3(cos(roll), sin(roll), 0), vec3(-sin(roll), cos(roll), 0), vec3(0, 0, 1));
+    return y * x * z;
+}
+
+int main(int argc, char **argv) {
+
+    CliInput cliInput;
+    try {
+        cliInput.addArgument(InputArgument("i", ArgumentType::String, "Path to source encoded data", true));
+        cliInput.addArgument(InputArgument("o", ArgumentType::String, "Output filename path", true));
+        cliInput.addArgument(InputArgument("yaw", ArgumentType::Float, "Rotation around y axis, degrees", false, "0"));
+        cliInput.addArgument(InputArgument("pitch", ArgumentType::Float, "Rotation around x axis, degrees", false, "0"));
+        cliInput.addArgument(InputArgument("roll", ArgumentType::Float, "Rotation around z axis, degrees", false, "0"));
+        cliInput.addArgument(InputArgument("alpha", ArgumentType::Boolean, "Load coefficients in rgba format. Default: alpha channel is ignored", false, "false"));
+
+        string commandLine;
+        for (int i = 0; i < argc; i++) {
+            commandLine += argv[i] + " "s;
+        }
+
+        ArgumentMap arguments = cliInput.parse(commandLine);
+        const string input = arguments["i"].value.asString;
+        const string output = arguments["o"].value.asString;
+        const real degrees = PI / 180;
+        const mat3 rotation = eulerRotation(arguments["yaw"].value.asFloat * degrees,
+                arguments["pitch"].value.asFloat * degrees, arguments["roll"].value.asFloat * degrees);
+
+        if (arguments["alpha"].value.asBoolean) {
+            const ShCoefficients<RGBA> coefficients = readRgba(input);
+            const ShRotation shRotation(rotation, order(coefficients));
+            write(output, shRotation(coefficients));
+        } else {
+            const ShCoefficients<RGB> coefficients = readRgb(input);
+            const ShRotation shRotation(rotation, order(coefficients));
+            write(output, shRotation(coefficients));
+        }
+    } catch (std::string &e) {
+        cout << e << endl;
+        cout << "Usage: rotate " << cliInput.brief(16, 4) << endl;
+        cout << cliInput.summary();
+    }
+    catch (const std::runtime_error &e) {
+        cerr << e.what() << endl;
+    }
+
+    return 0;
+}
\ No newline at end of file
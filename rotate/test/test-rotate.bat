@@ -0,0 +1,3 @@
+@echo off
+
+start ../rotate.exe  --i './sh-rgb.json' --o './sh-rotated.json' --yaw='90' --pitch='30'
\ No newline at end of file
@@ -0,0 +1,131 @@
+#ifndef SH_ADAPTIVEORDER_H
+#define SH_ADAPTIVEORDER_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "pixel_format.h"
+#include "ShCoefficients.h"
+#include "PlanarCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Energy of every band summed over channels, sum of squares of band coefficients. Basis is orthonormal, so the
+     * integral of squared signal over its domain is the sum of all bands. Every channel counts, so bands carrying
+     * chroma only aren't taken for empty
+     * @param coefficients
+     * @return order + 1 values
+     */
+    template<class R>
+    std::vector<real> bandEnergy(const ShCoefficients<R> &coefficients) {
+        std::vector<real> energy(order(coefficients) + 1u, 0);
+        for (size_t l = 0; l < energy.size(); l++) {
+            for (size_t k = l * l; k < (l + 1) * (l + 1); k++) {
+                energy[l] += squaredNorm(coefficients[k]);
+            }
+        }
+        return energy;
+    }
+
+    /**
+     * Energy of every band summed over channels
+     * @param coefficients
+     * @return order + 1 values
+     */
+    std::vector<real> bandEnergy(const PlanarCoefficients &coefficients) {
+        const std::vector<real> channels = planar::energy(coefficients);
+        std::vector<real> energy(coefficients.getOrder() + 1u, 0);
+        for (size_t i = 0; i < channels.size(); i++) {
+            energy[i % energy.size()] += channels[i];
+        }
+        return energy;
+    }
+
+    /**
+     * Lowest order whose bands hold given fraction of signal energy
+     * @param energy per band, see bandEnergy()
+     * @param fraction from 0 to 1
+     * @return
+     */
+    uint16_t orderForEnergy(const std::vector<real> &energy, real fraction) {
+        real total = 0;
+        for (real band : energy) {
+            total += band;
+        }
+        real kept = 0;
+        for (size_t l = 0; l < energy.size(); l++) {
+            kept += energy[l];
+            if (kept >= fraction * total) {
+                return (uint16_t) l;
+            }
+        }
+        return (uint16_t) (energy.empty() ? 0 : energy.size() - 1);
+    }
+
+    /**
+     * Lowest order whose truncation error doesn't exceed given value. Error is root mean square of dropped bands
+     * over the domain of the basis: sqrt(sum of their energy / measure)
+     * @param energy per band, see bandEnergy()
+     * @param error
+     * @param measure solid angle of the domain, 4pi for the sphere, 2pi for Hemispherical Harmonics
+     * @return
+     */
+    uint16_t orderForError(const std::vector<real> &energy, real error, real measure = math::PI4) {
+        real dropped = 0;
+        size_t l = energy.size();
+        while (l > 1 && std::sqrt((dropped + energy[l - 1]) / measure) <= error) {
+            dropped += energy[--l];
+        }
+        return (uint16_t) (l == 0 ? 0 : l - 1);
+    }
+
+    /**
+     * Copy of coefficients without bands above given order
+     * @param coefficients
+     * @param order must not exceed order of coefficients
+     * @return
+     */
+    template<class R>
+    ShCoefficients<R> truncate(const ShCoefficients<R> &coefficients, uint16_t order) {
+        const size_t n = (order + 1u) * (order + 1u);
+        if (n > coefficients.size()) {
+            throw std::runtime_error("truncate: order " + std::to_string(order) + " exceeds order of coefficients");
+        }
+        return ShCoefficients<R>(coefficients.begin(), coefficients.begin() + n);
+    }
+
+    /**
+     * sum(weights[i] * sources[i]) of signals of any orders: result has the highest order of sources, every source
+     * adds its own bands only
+     * @param sources
+     * @param weights
+     * @return
+     */
+    template<class R>
+    ShCoefficients<R> blend(const std::vector<const ShCoefficients<R> *> &sources, const std::vector<real> &weights) {
+        if (sources.size() != weights.size()) {
+            throw std::runtime_error("blend: a weight per source is expected");
+        }
+        size_t n = 0;
+        for (const ShCoefficients<R> *source : sources) {
+            n = std::max(n, source->size());
+        }
+        ShCoefficients<R> blended(n, R(0));
+        for (size_t i = 0; i < sources.size(); i++) {
+            const ShCoefficients<R> &source = *sources[i];
+            for (size_t k = 0; k < source.size(); k++) {
+                blended[k] += source[k] * weights[i];
+            }
+        }
+        return blended;
+    }
+}
+
+#endif //SH_ADAPTIVEORDER_H
@@ -0,0 +1,81 @@
+#ifndef SH_ALIASTABLE_H
+#define SH_ALIASTABLE_H
+
+#include <vector>
+#include <inttypes.h>
+#include <stdexcept>
+#include <algorithm>
+
+#include "real.h"
+
+namespace sh {
+
+    /**
+     * Walker's alias method (Vose's construction): draws index with probability proportional to its weight in O(1)
+     */
+    class AliasTable {
+    protected:
+        std::vector<real> probabilities;
+        std::vector<real> thresholds;
+        std::vector<uint32_t> aliases;
+    public:
+        AliasTable() = default;
+
+        explicit AliasTable(const std::vector<real> &weights) :
+                probabilities(weights.size()), thresholds(weights.size()), aliases(weights.size()) {
+            const size_t n = weights.size();
+            real total = 0;
+            for (auto w : weights) {
+                total += w;
+            }
+            if (n == 0 || total <= 0) {
+                throw std::runtime_error("AliasTable: weights must have positive sum");
+            }
+
+            std::vector<uint32_t> small, large;
+            for (size_t i = 0; i < n; i++) {
+                probabilities[i] = weights[i] / total;
+                thresholds[i] = probabilities[i] * n;
+                aliases[i] = (uint32_t) i;
+                (thresholds[i] < 1 ? small : large).push_back((uint32_t) i);
+            }
+            while (!small.empty() && !large.empty()) {
+                const uint32_t s = small.back(), l = large.back();
+                small.pop_back();
+                aliases[s] = l;
+                thresholds[l] -= 1 - thresholds[s];
+                if (thresholds[l] < 1) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            for (auto i : small) {
+                thresholds[i] = 1;
+            }
+            for (auto i : large) {
+                thresholds[i] = 1;
+            }
+        }
+
+        /**
+         * @param u uniform number in [0, 1)
+         * @return index drawn with probability(index)
+         */
+        uint32_t sample(real u) const {
+            const size_t n = thresholds.size();
+            const real scaled = u * n;
+            const auto i = (uint32_t) std::min<size_t>((size_t) scaled, n - 1);
+            return scaled - i < thresholds[i] ? i : aliases[i];
+        }
+
+        real probability(uint32_t i) const {
+            return probabilities[i];
+        }
+
+        size_t size() const {
+            return probabilities.size();
+        }
+    };
+}
+
+#endif //SH_ALIASTABLE_H
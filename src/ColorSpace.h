@@ -0,0 +1,267 @@
+#ifndef SH_COLORSPACE_H
+#define SH_COLORSPACE_H
+
+#include <array>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "pixel_format.h"
+#include "CubeMap.h"
+#include "ShCoefficients.h"
+#include "TexelBasis.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    enum class ColorSpace {
+        Rgb,
+        YCoCg
+    };
+
+    namespace color {
+
+        /**
+         * Luma and two chroma differences, chroma of natural images is much smoother than luma
+         * @param rgb
+         * @return (y, co, cg) in (r, g, b)
+         */
+        template<class T>
+        RGBStruct<T> toYCoCg(const RGBStruct<T> &rgb) {
+            return RGBStruct<T>(
+                    rgb.r * 0.25 + rgb.g * 0.5 + rgb.b * 0.25,
+                    rgb.r * 0.5 - rgb.b * 0.5,
+                    -rgb.r * 0.25 + rgb.g * 0.5 - rgb.b * 0.25);
+        }
+
+        /**
+         * Inverse of toYCoCg()
+         * @param ycocg (y, co, cg) in (r, g, b)
+         * @return
+         */
+        template<class T>
+        RGBStruct<T> fromYCoCg(const RGBStruct<T> &ycocg) {
+            const T base = ycocg.r - ycocg.b;
+            return RGBStruct<T>(base + ycocg.g, ycocg.r + ycocg.b, base - ycocg.g);
+        }
+
+        /**
+         * Sum of products kept in independent partial sums, so long channel isn't bound by latency of additions
+         * @param a
+         * @param b
+         * @param n
+         * @return
+         */
+        inline real dot(const real *a, const real *b, size_t n) {
+            real sums[4] = {0, 0, 0, 0};
+            size_t k = 0;
+            for (; k + 4 <= n; k += 4) {
+                sums[0] += a[k] * b[k];
+                sums[1] += a[k + 1] * b[k + 1];
+                sums[2] += a[k + 2] * b[k + 2];
+                sums[3] += a[k + 3] * b[k + 3];
+            }
+            for (; k < n; k++) {
+                sums[0] += a[k] * b[k];
+            }
+            return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        }
+
+        template<class T>
+        RGBStruct<T> to(ColorSpace space, const RGBStruct<T> &rgb) {
+            return space == ColorSpace::YCoCg ? toYCoCg(rgb) : rgb;
+        }
+
+        template<class T>
+        RGBStruct<T> from(ColorSpace space, const RGBStruct<T> &value) {
+            return space == ColorSpace::YCoCg ? fromYCoCg(value) : value;
+        }
+    }
+
+    /**
+     * Color signal kept channel by channel in given color space, every channel is truncated to its own order.
+     * Color transform is linear, so coefficients of transformed signal are transformed coefficients
+     */
+    struct ColorCoefficients {
+        ColorSpace space = ColorSpace::Rgb;
+        std::array<ShCoefficients<real>, 3> channels;
+
+        /**
+         * Highest order of channels
+         * @return
+         */
+        uint16_t getOrder() const {
+            uint16_t highest = 0;
+            for (auto &channel : channels) {
+                highest = std::max(highest, order(channel));
+            }
+            return highest;
+        }
+
+        /**
+         * Highest order all channels hold, bands above it are missing in some channel
+         * @return
+         */
+        uint16_t getCommonOrder() const {
+            uint16_t lowest = order(channels[0]);
+            for (auto &channel : channels) {
+                lowest = std::min(lowest, order(channel));
+            }
+            return lowest;
+        }
+    };
+
+    /**
+     * Move color signal to color space and cut every channel to its order
+     * @param coefficients
+     * @param space
+     * @param orders per channel of the space, must not exceed order of coefficients
+     * @return
+     */
+    ColorCoefficients separate(const ShCoefficients<RGB> &coefficients, ColorSpace space,
+            const std::array<uint16_t, 3> &orders) {
+        ColorCoefficients separated;
+        separated.space = space;
+        for (size_t c = 0; c < 3; c++) {
+            const size_t n = (orders[c] + 1u) * (orders[c] + 1u);
+            if (n > coefficients.size()) {
+                throw std::runtime_error("separate: channel order " + std::to_string(orders[c]) +
+                                         " exceeds order of coefficients");
+            }
+            separated.channels[c].resize(n);
+        }
+        for (size_t k = 0; k < coefficients.size(); k++) {
+            const RGB value = color::to(space, coefficients[k]);
+            const real components[] = {value.r, value.g, value.b};
+            for (size_t c = 0; c < 3; c++) {
+                if (k < separated.channels[c].size()) {
+                    separated.channels[c][k] = components[c];
+                }
+            }
+        }
+        return separated;
+    }
+
+    /**
+     * Color signal back in RGB at the highest order of channels, bands missing in channel are zero
+     * @param coefficients
+     * @return
+     */
+    ShCoefficients<RGB> combine(const ColorCoefficients &coefficients) {
+        const uint16_t order = coefficients.getOrder();
+        ShCoefficients<RGB> combined((order + 1u) * (order + 1u), RGB(0));
+        for (size_t k = 0; k < combined.size(); k++) {
+            const auto &channels = coefficients.channels;
+            const RGB value(
+                    k < channels[0].size() ? channels[0][k] : 0,
+                    k < channels[1].size() ? channels[1][k] : 0,
+                    k < channels[2].size() ? channels[2][k] : 0);
+            combined[k] = color::from(coefficients.space, value);
+        }
+        return combined;
+    }
+
+    /**
+     * Get decoded color at unit direction, basis is evaluated once up to the highest order and every channel is
+     * summed up to its own order only
+     * @param coefficients
+     * @param direction
+     * @return
+     */
+    RGB decode(const ColorCoefficients &coefficients, const vec3 &direction) {
+        const uint16_t order = coefficients.getOrder();
+        std::vector<real> y((order + 1u) * (order + 1u));
+        math::basis(order, direction, y.data());
+        real components[3];
+        for (size_t c = 0; c < 3; c++) {
+            const ShCoefficients<real> &channel = coefficients.channels[c];
+            components[c] = color::dot(channel.data(), y.data(), channel.size());
+        }
+        return color::from(coefficients.space, RGB(components[0], components[1], components[2]));
+    }
+
+    /**
+     * Convert color signal into cubemap, see decode(coefficients, size) for RGB. Every channel costs as much as
+     * its own order needs
+     * @tparam F
+     * @param coefficients
+     * @param size
+     * @return
+     */
+    template<class F>
+    std::shared_ptr<CubeMap<F>> decode(const ColorCoefficients &coefficients, int size) {
+        using namespace std;
+
+        map<CubeMapFaceEnum, shared_ptr<PixelArray<F>>> faces;
+        for (auto &item : faceTransforms()) {
+            faces[item.first] = make_shared<PixelArray<F>>(new F[size * size], size, size);
+        }
+
+        // channels moved by every group element as in decode of RGB signal, channel after channel per element
+        const uint16_t order = coefficients.getOrder();
+        const symmetry::BasisAction action(order);
+        size_t offsets[4] = {0};
+        for (size_t c = 0; c < 3; c++) {
+            offsets[c + 1] = offsets[c] + coefficients.channels[c].size();
+        }
+        const size_t width = offsets[3];
+        vector<real> moved(symmetry::ELEMENTS * width, 0);
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t c = 0; c < 3; c++) {
+                const ShCoefficients<real> &channel = coefficients.channels[c];
+                real *out = &moved[element * width + offsets[c]];
+                for (size_t k = 0; k < channel.size(); k++) {
+                    // index keeps band, so moved channel keeps its order
+                    out[action.index(element, k)] = channel[k] * action.sign(element, k);
+                }
+            }
+        }
+
+        auto texel = [&](const real *c, const real *y) {
+            const RGB value = RGB(
+                    color::dot(c, y, offsets[1]),
+                    color::dot(c + offsets[1], y, offsets[2] - offsets[1]),
+                    color::dot(c + offsets[2], y, offsets[3] - offsets[2]));
+            return F(color::from(coefficients.space, value));
+        };
+
+        if (TexelBasis::affordable((uint16_t) size, order)) {
+            // texels straight in memory order, orbit tables tell basis and element of every texel
+            const auto basis = TexelBasis::get((uint16_t) size, order);
+            const auto texelOrbits = symmetry::TexelOrbits::get(size);
+            for (auto &item : faceTransforms()) {
+                F *data = faces[item.first]->getData();
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        const real *c = &moved[texelOrbits->element(item.first, i, j) * width];
+                        data[i * size + j] = texel(c, (*basis)(texelOrbits->orbit(item.first, i, j)));
+                    }
+                }
+            }
+        } else {
+            vector<real> center((order + 1u) * (order + 1u));
+            symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+                math::basis(order, orbit.direction, center.data());
+                for (uint8_t k = 0; k < orbit.size; k++) {
+                    const symmetry::Texel &t = orbit.images[k].texel;
+                    (*faces[t.face])[t.i][t.j] = texel(&moved[orbit.images[k].element * width], center.data());
+                }
+            });
+        }
+        return make_shared<CubeMap<F>>(
+                faces[CubeMapFaceEnum::PositiveX],
+                faces[CubeMapFaceEnum::NegativeX],
+                faces[CubeMapFaceEnum::PositiveY],
+                faces[CubeMapFaceEnum::NegativeY],
+                faces[CubeMapFaceEnum::PositiveZ],
+                faces[CubeMapFaceEnum::NegativeZ]);
+    }
+}
+
+#endif //SH_COLORSPACE_H
@@ -7,6 +7,7 @@
 
 #include <map>
 #include <memory>
+#include <algorithm>
 
 #include "PixelArray.h"
 #include "shmath.h"
@@ -22,6 +23,24 @@ namespace sh {
         NegativeZ,
     };
 
+    /**
+     * Rotations from face local space into cubemap space. In local space face is the plane z = -1, texel columns go
+     * along x (s) and rows along y (t), both in [-1, 1]
+     * @return
+     */
+    const std::map<CubeMapFaceEnum, mat3> &faceTransforms() {
+        using namespace math;
+        static const std::map<CubeMapFaceEnum, mat3> transformLookup = {
+                {CubeMapFaceEnum::PositiveX, mat3(-axis::z, axis::y, -axis::x)},
+                {CubeMapFaceEnum::NegativeX, mat3(axis::z, axis::y, axis::x)},
+                {CubeMapFaceEnum::PositiveY, mat3(axis::x, -axis::z, -axis::y)},
+                {CubeMapFaceEnum::NegativeY, mat3(axis::x, axis::z, axis::y)},
+                {CubeMapFaceEnum::PositiveZ, mat3(axis::x, axis::y, -axis::z)},
+                {CubeMapFaceEnum::NegativeZ, mat3(-axis::x, axis::y, axis::z)}
+        };
+        return transformLookup;
+    }
+
     template<class T>
     class CubeMap {
     public:
@@ -60,6 +79,75 @@ namespace sh {
         uint16_t getHeight()  {
             return faces.begin()->second->getHeight();
         }
+
+        /**
+         * All faces are square and of the same size, texel walks of projection expect that
+         * @return
+         */
+        bool isSquare() {
+            const uint16_t size = getWidth();
+            for (auto &face : faces) {
+                if (face.second->getWidth() != size || face.second->getHeight() != size) {
+                    return false;
+                }
+            }
+            return true;
+        }
     };
+
+    /**
+     * Deep copy of cubemap, faces don't share pixel data with the source
+     * @param cubemap
+     * @return
+     */
+    template<class T>
+    std::shared_ptr<CubeMap<T>> clone(CubeMap<T> &cubemap) {
+        std::map<CubeMapFaceEnum, std::shared_ptr<PixelArray<T>>> faces;
+        const int w = cubemap.getWidth(), h = cubemap.getHeight();
+        for (auto &item : faceTransforms()) {
+            T *data = new T[w * h];
+            std::copy(cubemap[item.first]->getData(), cubemap[item.first]->getData() + w * h, data);
+            faces[item.first] = std::make_shared<PixelArray<T>>(data, w, h);
+        }
+        return std::make_shared<CubeMap<T>>(
+                faces[CubeMapFaceEnum::PositiveX],
+                faces[CubeMapFaceEnum::NegativeX],
+                faces[CubeMapFaceEnum::PositiveY],
+                faces[CubeMapFaceEnum::NegativeY],
+                faces[CubeMapFaceEnum::PositiveZ],
+                faces[CubeMapFaceEnum::NegativeZ]);
+    }
+
+    /**
+     * Next mip level: every texel is the average of 2x2 block of the source
+     * @param cubemap
+     * @return
+     */
+    template<class T>
+    std::shared_ptr<CubeMap<T>> downsample(CubeMap<T> &cubemap) {
+        std::map<CubeMapFaceEnum, std::shared_ptr<PixelArray<T>>> faces;
+        const int w = cubemap.getWidth(), h = cubemap.getHeight();
+        const int hw = std::max(1, w / 2), hh = std::max(1, h / 2);
+        for (auto &item : faceTransforms()) {
+            const T *source = cubemap[item.first]->getData();
+            T *data = new T[hw * hh];
+            for (int i = 0; i < hh; i++) {
+                for (int j = 0; j < hw; j++) {
+                    const int i0 = std::min(2 * i, h - 1), i1 = std::min(2 * i + 1, h - 1);
+                    const int j0 = std::min(2 * j, w - 1), j1 = std::min(2 * j + 1, w - 1);
+                    data[i * hw + j] = (source[i0 * w + j0] + source[i0 * w + j1] + source[i1 * w + j0] +
+                                        source[i1 * w + j1]) * 0.25f;
+                }
+            }
+            faces[item.first] = std::make_shared<PixelArray<T>>(data, hw, hh);
+        }
+        return std::make_shared<CubeMap<T>>(
+                faces[CubeMapFaceEnum::PositiveX],
+                faces[CubeMapFaceEnum::NegativeX],
+                faces[CubeMapFaceEnum::PositiveY],
+                faces[CubeMapFaceEnum::NegativeY],
+                faces[CubeMapFaceEnum::PositiveZ],
+                faces[CubeMapFaceEnum::NegativeZ]);
+    }
 }
 #endif //SH_CUBEMAP_H
@@ -0,0 +1,129 @@
+#ifndef SH_CUBEMAPDISTRIBUTION_H
+#define SH_CUBEMAPDISTRIBUTION_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <cmath>
+
+#include "real.h"
+#include "pixel_format.h"
+#include "CubeMap.h"
+#include "AliasTable.h"
+
+namespace sh {
+
+    real projectedArea(real s, real t) {
+        return std::atan2(s * t, std::sqrt(s * s + t * t + 1));
+    }
+
+    real solidAngle(real s, real t, real ds, real dt) {
+        ds = ds * 0.5;
+        dt = dt * 0.5;
+        real C = projectedArea(s + ds, t + dt);
+        real A = projectedArea(s - ds, t - dt);
+        real B = projectedArea(s + ds, t - dt);
+        real D = projectedArea(s - ds, t + dt);
+        return A - B + C - D;
+    }
+
+    template<class F>
+    struct CubeMapSample {
+        vec3 direction;
+        F value;
+        real pdf;
+    };
+
+    /**
+     * Luminance distribution of cubemap texels weighted by their solid angle. Faces are picked by their total weight,
+     * texels inside of face by per-face table, both with alias method, so every sample costs O(1).
+     * A small fraction of uniform density is mixed in, thus black regions are still reachable and pdf never vanishes
+     */
+    template<class F>
+    class CubeMapDistribution {
+    protected:
+        std::shared_ptr<CubeMap<F>> cubemap;
+        AliasTable faceTable;
+        std::map<CubeMapFaceEnum, AliasTable> texelTables;
+        std::vector<CubeMapFaceEnum> faces;
+        uint16_t width;
+        uint16_t height;
+    public:
+        /**
+         * @param cubemap
+         * @param uniform fraction of average texel luminance added to every texel
+         */
+        explicit CubeMapDistribution(std::shared_ptr<CubeMap<F>> cubemap, real uniform = 0.05) : cubemap(cubemap) {
+            width = cubemap->getWidth();
+            height = cubemap->getHeight();
+            const real ds = 2.0 / width, dt = 2.0 / height;
+
+            real total = 0, area = 0;
+            std::map<CubeMapFaceEnum, std::vector<real>> weights;
+            for (auto &item : faceTransforms()) {
+                const F *data = (*cubemap)[item.first]->getData();
+                auto &w = weights[item.first];
+                w.resize(width * height);
+                for (int i = 0; i < height; i++) {
+                    const real t = -1 + dt * (i + 0.5);
+                    for (int j = 0; j < width; j++) {
+                        const real s = -1 + ds * (j + 0.5);
+                        const real dw = solidAngle(std::abs(s), std::abs(t), ds, dt);
+                        const real l = std::max<real>(0, luminance(data[i * width + j]));
+                        w[i * width + j] = l * dw;
+                        total += l * dw;
+                        area += dw;
+                    }
+                }
+            }
+
+            const real floor = total > 0 ? uniform * total / area : 1;
+            std::vector<real> faceWeights;
+            for (auto &item : weights) {
+                real sum = 0;
+                int k = 0;
+                for (int i = 0; i < height; i++) {
+                    const real t = -1 + dt * (i + 0.5);
+                    for (int j = 0; j < width; j++, k++) {
+                        const real s = -1 + ds * (j + 0.5);
+                        item.second[k] += floor * solidAngle(std::abs(s), std::abs(t), ds, dt);
+                        sum += item.second[k];
+                    }
+                }
+                faces.push_back(item.first);
+                faceWeights.push_back(sum);
+                texelTables[item.first] = AliasTable(item.second);
+            }
+            faceTable = AliasTable(faceWeights);
+        }
+
+        /**
+         * Draw direction distributed by luminance. Texel is picked with alias tables, direction is uniform over the
+         * texel in face coordinates
+         * @param u1 uniform number for face selection
+         * @param u2 uniform number for texel selection
+         * @param jitter uniform position inside of texel
+         * @return direction, texel value and solid angle density of the direction
+         */
+        CubeMapSample<F> sample(real u1, real u2, const vec2 &jitter) const {
+            const uint32_t f = faceTable.sample(u1);
+            const CubeMapFaceEnum face = faces[f];
+            const AliasTable &texels = texelTables.at(face);
+            const uint32_t texel = texels.sample(u2);
+            const int i = texel / width, j = texel % width;
+
+            const real ds = 2.0 / width, dt = 2.0 / height;
+            const real s = -1 + ds * (j + jitter.x), t = -1 + dt * (i + jitter.y);
+            const real d2 = s * s + t * t + 1;
+
+            CubeMapSample<F> result;
+            result.direction = faceTransforms().at(face) * (vec3(s, t, -1) / std::sqrt(d2));
+            result.value = (*cubemap)[face]->getData()[texel];
+            // area density in face plane to solid angle density: dA / dw = (s^2 + t^2 + 1)^(3/2)
+            result.pdf = faceTable.probability(f) * texels.probability(texel) / (ds * dt) * d2 * std::sqrt(d2);
+            return result;
+        }
+    };
+}
+
+#endif //SH_CUBEMAPDISTRIBUTION_H
@@ -0,0 +1,251 @@
+#ifndef SH_CUBEMAPSYMMETRY_H
+#define SH_CUBEMAPSYMMETRY_H
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+
+namespace sh {
+
+    /**
+     * Symmetries of the cube which keep the polar axis y: sign changes of x, y, z and swap of x and z.
+     * Every element maps texel centers onto texel centers and every basis function onto a single basis function
+     * with a sign: y(l, m, g(d)) = sign * y(l, m', d), so the basis has to be evaluated only on 1/16 of texels
+     * (a quadrant of PositiveZ face and an octant of PositiveY face).
+     * Symmetries mixing y with other axes turn basis functions into combinations of whole band, thus they are not used
+     */
+    namespace symmetry {
+
+        const uint8_t FLIP_X = 1u;
+        const uint8_t FLIP_Y = 2u;
+        const uint8_t FLIP_Z = 4u;
+        const uint8_t SWAP_XZ = 8u;
+        const uint8_t ELEMENTS = 16u;
+
+        /**
+         * Apply group element: sign changes first, then the swap
+         * @param element combination of FLIP_X, FLIP_Y, FLIP_Z and SWAP_XZ
+         * @param d
+         * @return
+         */
+        vec3 apply(uint8_t element, const vec3 &d) {
+            const vec3 flipped(element & FLIP_X ? -d.x : d.x, element & FLIP_Y ? -d.y : d.y,
+                    element & FLIP_Z ? -d.z : d.z);
+            return element & SWAP_XZ ? vec3(flipped.z, flipped.y, flipped.x) : flipped;
+        }
+
+        struct Texel {
+            CubeMapFaceEnum face;
+            int i;
+            int j;
+        };
+
+        /**
+         * Texel of face with given size containing the direction
+         * @param d
+         * @param size
+         * @return
+         */
+        Texel locate(const vec3 &d, int size) {
+            const real ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+            CubeMapFaceEnum face;
+            if (ax >= ay && ax >= az) {
+                face = d.x > 0 ? CubeMapFaceEnum::PositiveX : CubeMapFaceEnum::NegativeX;
+            } else if (ay >= az) {
+                face = d.y > 0 ? CubeMapFaceEnum::PositiveY : CubeMapFaceEnum::NegativeY;
+            } else {
+                face = d.z > 0 ? CubeMapFaceEnum::PositiveZ : CubeMapFaceEnum::NegativeZ;
+            }
+            const vec3 local = glm::transpose(faceTransforms().at(face)) * d;
+            const real s = local.x / -local.z, t = local.y / -local.z;
+            const int j = std::min(size - 1, std::max(0, (int) std::floor((s + 1) * 0.5 * size)));
+            const int i = std::min(size - 1, std::max(0, (int) std::floor((t + 1) * 0.5 * size)));
+            return {face, i, j};
+        }
+
+        /**
+         * Action of every group element on basis functions up to given order:
+         * y(k, g(d)) = sign[g][k] * y(index[g][k], d), k = l * (l + 1) + m
+         */
+        class BasisAction {
+        protected:
+            std::vector<real> signs;
+            std::vector<uint32_t> indices;
+            size_t stride;
+        public:
+            explicit BasisAction(uint16_t order) : stride((order + 1u) * (order + 1u)) {
+                signs.resize(ELEMENTS * stride);
+                indices.resize(ELEMENTS * stride);
+                for (uint8_t element = 0; element < ELEMENTS; element++) {
+                    for (int l = 0; l <= order; l++) {
+                        for (int m = -l; m <= l; m++) {
+                            const int am = std::abs(m);
+                            real sign = 1;
+                            int target = m;
+                            // the swap is applied last, so it acts on basis first: phi -> PI / 2 - phi
+                            if (element & SWAP_XZ) {
+                                if (am % 2 == 0) {
+                                    sign = (am / 2) % 2 ? -1 : 1;
+                                    sign = m < 0 ? -sign : sign;
+                                } else {
+                                    sign = ((am - 1) / 2) % 2 ? -1 : 1;
+                                    target = -m;
+                                }
+                            }
+                            // tetta -> PI - tetta
+                            if (element & FLIP_Y) {
+                                sign = (l + am) % 2 ? -sign : sign;
+                            }
+                            // phi -> -phi
+                            if ((element & FLIP_X) && target < 0) {
+                                sign = -sign;
+                            }
+                            // phi -> PI - phi
+                            if (element & FLIP_Z) {
+                                const real parity = am % 2 ? -1 : 1;
+                                sign *= target < 0 ? -parity : parity;
+                            }
+                            const size_t k = element * stride + l * (l + 1) + m;
+                            signs[k] = sign;
+                            indices[k] = (uint32_t) (l * (l + 1) + target);
+                        }
+                    }
+                }
+            }
+
+            real sign(uint8_t element, size_t k) const {
+                return signs[element * stride + k];
+            }
+
+            uint32_t index(uint8_t element, size_t k) const {
+                return indices[element * stride + k];
+            }
+        };
+
+        struct Image {
+            Texel texel;
+            uint8_t element;
+        };
+
+        /**
+         * Texel of canonical region together with all distinct texels it's mapped to by the group (itself included)
+         */
+        struct Orbit {
+            Texel texel;
+            vec3 direction;
+            uint8_t size;
+            Image images[ELEMENTS];
+        };
+
+        /**
+         * Walk canonical texels of cubemap with given face size, every texel of cubemap belongs to exactly one orbit
+         * @param size
+         * @param visit called with every Orbit
+         */
+        template<class Visit>
+        void orbits(int size, Visit &&visit) {
+            // every orbit has a texel on PositiveZ or PositiveY, canonical one is the first of them in this order
+            auto rank = [size](const Texel &texel) -> long {
+                const long face = texel.face == CubeMapFaceEnum::PositiveZ ? 0 :
+                                  texel.face == CubeMapFaceEnum::PositiveY ? 1 : 2 + (long) texel.face;
+                return (face * size + texel.i) * size + texel.j;
+            };
+
+            const real d = 2.0 / size;
+            for (CubeMapFaceEnum face : {CubeMapFaceEnum::PositiveZ, CubeMapFaceEnum::PositiveY}) {
+                const mat3 &transform = faceTransforms().at(face);
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        Orbit orbit;
+                        orbit.texel = {face, i, j};
+                        orbit.direction = transform * glm::normalize(vec3(-1 + d * (j + 0.5), -1 + d * (i + 0.5), -1));
+                        orbit.size = 0;
+
+                        const long own = rank(orbit.texel);
+                        bool canonical = true;
+                        for (uint8_t element = 0; element < ELEMENTS && canonical; element++) {
+                            const Texel image = locate(apply(element, orbit.direction), size);
+                            const long r = rank(image);
+                            canonical = r >= own;
+                            bool duplicate = false;
+                            for (uint8_t k = 0; k < orbit.size && !duplicate; k++) {
+                                duplicate = rank(orbit.images[k].texel) == r;
+                            }
+                            if (!duplicate) {
+                                orbit.images[orbit.size++] = {image, element};
+                            }
+                        }
+                        if (canonical) {
+                            visit(orbit);
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * Orbit and group element of every texel of cubemap with given face size: texel is the image of the canonical
+         * texel of orbit under element. Orbits are numbered in the order of orbits(), so per orbit tables (integrals,
+         * basis) apply to any texel
+         */
+        class TexelOrbits {
+        protected:
+            int size;
+            std::vector<uint32_t> orbitIndices;
+            std::vector<uint8_t> elements;
+
+        public:
+            explicit TexelOrbits(int size) : size(size), orbitIndices(6u * size * size), elements(6u * size * size) {
+                uint32_t index = 0;
+                orbits(size, [this, &index](const Orbit &orbit) {
+                    for (uint8_t k = 0; k < orbit.size; k++) {
+                        const Texel &texel = orbit.images[k].texel;
+                        const size_t at = ((size_t) texel.face * this->size + texel.i) * this->size + texel.j;
+                        orbitIndices[at] = index;
+                        elements[at] = orbit.images[k].element;
+                    }
+                    index++;
+                });
+            }
+
+            int getSize() const {
+                return size;
+            }
+
+            uint32_t orbit(CubeMapFaceEnum face, int i, int j) const {
+                return orbitIndices[((size_t) face * size + i) * size + j];
+            }
+
+            uint8_t element(CubeMapFaceEnum face, int i, int j) const {
+                return elements[((size_t) face * size + i) * size + j];
+            }
+
+            /**
+             * Shared map for face size, built on first request
+             * @param size
+             * @return
+             */
+            static std::shared_ptr<const TexelOrbits> get(int size) {
+                static std::mutex mutex;
+                static std::map<int, std::shared_ptr<const TexelOrbits>> cache;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                auto &texelOrbits = cache[size];
+                if (!texelOrbits) {
+                    texelOrbits = std::make_shared<const TexelOrbits>(size);
+                }
+                return texelOrbits;
+            }
+        };
+    }
+}
+
+#endif //SH_CUBEMAPSYMMETRY_H
@@ -0,0 +1,277 @@
+#ifndef SH_FIXEDORDER_H
+#define SH_FIXEDORDER_H
+
+#include <array>
+#include <vector>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "ShCoefficients.h"
+#include "TexelIntegrals.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Max order with closed form basis and fixed size coefficients
+     */
+    const uint16_t FIXED_ORDER = 4;
+
+    /**
+     * Coefficients of order known at compile time, kept in place instead of heap
+     */
+    template<class R, uint16_t Order>
+    using ShCoefficientsN = std::array<R, (Order + 1u) * (Order + 1u)>;
+
+    /**
+     * Order of fixed size coefficients
+     * @param size (order + 1)^2
+     * @return
+     */
+    constexpr uint16_t fixedOrder(size_t size) {
+        uint16_t order = 0;
+        while ((order + 1u) * (order + 1u) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    namespace math {
+
+        /**
+         * Basis functions of band L as polynomials of direction. Polynomials are written for polar axis z and
+         * azimuth measured from x, with (x, y, z) = (dir.z, dir.x, dir.y) this is the basis of y(l, m, phi, tetta)
+         */
+        template<int L>
+        struct Band;
+
+        template<>
+        struct Band<0> {
+            static void eval(real, real, real, real *out) {
+                out[0] = 0.282094791773878;
+            }
+        };
+
+        template<>
+        struct Band<1> {
+            static void eval(real x, real y, real z, real *out) {
+                out[1] = -0.488602511902920 * y;
+                out[2] = 0.488602511902920 * z;
+                out[3] = -0.488602511902920 * x;
+            }
+        };
+
+        template<>
+        struct Band<2> {
+            static void eval(real x, real y, real z, real *out) {
+                out[4] = 1.092548430592079 * x * y;
+                out[5] = -1.092548430592079 * y * z;
+                out[6] = 0.315391565252520 * (3 * z * z - 1);
+                out[7] = -1.092548430592079 * x * z;
+                out[8] = 0.546274215296040 * (x * x - y * y);
+            }
+        };
+
+        template<>
+        struct Band<3> {
+            static void eval(real x, real y, real z, real *out) {
+                const real x2 = x * x, y2 = y * y, z2 = z * z;
+                out[9] = -0.590043589926644 * y * (3 * x2 - y2);
+                out[10] = 2.890611442640554 * x * y * z;
+                out[11] = -0.457045799464466 * y * (5 * z2 - 1);
+                out[12] = 0.373176332590115 * z * (5 * z2 - 3);
+                out[13] = -0.457045799464466 * x * (5 * z2 - 1);
+                out[14] = 1.445305721320277 * z * (x2 - y2);
+                out[15] = -0.590043589926644 * x * (x2 - 3 * y2);
+            }
+        };
+
+        template<>
+        struct Band<4> {
+            static void eval(real x, real y, real z, real *out) {
+                const real x2 = x * x, y2 = y * y, z2 = z * z;
+                out[16] = 2.503342941796705 * x * y * (x2 - y2);
+                out[17] = -1.770130769779931 * y * z * (3 * x2 - y2);
+                out[18] = 0.946174695757560 * x * y * (7 * z2 - 1);
+                out[19] = -0.669046543557289 * y * z * (7 * z2 - 3);
+                out[20] = 0.105785546915204 * (35 * z2 * z2 - 30 * z2 + 3);
+                out[21] = -0.669046543557289 * x * z * (7 * z2 - 3);
+                out[22] = 0.473087347878780 * (x2 - y2) * (7 * z2 - 1);
+                out[23] = -1.770130769779931 * x * z * (x2 - 3 * y2);
+                out[24] = 0.625835735449176 * (x2 * (x2 - 3 * y2) - y2 * (3 * x2 - y2));
+            }
+        };
+
+        template<int L>
+        struct Bands {
+            static void eval(real x, real y, real z, real *out) {
+                Bands<L - 1>::eval(x, y, z, out);
+                Band<L>::eval(x, y, z, out);
+            }
+        };
+
+        template<>
+        struct Bands<0> {
+            static void eval(real x, real y, real z, real *out) {
+                Band<0>::eval(x, y, z, out);
+            }
+        };
+
+        /**
+         * Evaluate all basis functions up to Order at unit direction in closed form, same values as
+         * basis(order, dir, out)
+         * @param dir unit direction
+         * @param out (Order + 1)^2 values, index l * (l + 1) + m
+         */
+        template<uint16_t Order>
+        void basis(const vec3 &dir, real *out) {
+            static_assert(Order <= FIXED_ORDER, "closed form basis is available up to FIXED_ORDER");
+            Bands<Order>::eval(dir.z, dir.x, dir.y, out);
+        }
+    }
+
+    /**
+     * Call body with std::integral_constant of given order, so fixed order kernels are picked at runtime
+     * @param order must not exceed FIXED_ORDER
+     * @param body generic callable
+     * @return what body returns
+     */
+    template<class Body>
+    auto dispatch(uint16_t order, Body &&body) -> decltype(body(std::integral_constant<uint16_t, 0>())) {
+        switch (order) {
+            case 0:
+                return body(std::integral_constant<uint16_t, 0>());
+            case 1:
+                return body(std::integral_constant<uint16_t, 1>());
+            case 2:
+                return body(std::integral_constant<uint16_t, 2>());
+            case 3:
+                return body(std::integral_constant<uint16_t, 3>());
+            case 4:
+                return body(std::integral_constant<uint16_t, 4>());
+            default:
+                throw std::runtime_error("dispatch: order " + std::to_string(order) + " exceeds FIXED_ORDER");
+        }
+    }
+
+    /**
+     * Copy of coefficients truncated or padded with zeros to Order
+     * @param coefficients
+     * @return
+     */
+    template<uint16_t Order, class R>
+    ShCoefficientsN<R, Order> fixed(const ShCoefficients<R> &coefficients) {
+        ShCoefficientsN<R, Order> result;
+        for (size_t k = 0; k < result.size(); k++) {
+            result[k] = k < coefficients.size() ? coefficients[k] : R(0);
+        }
+        return result;
+    }
+
+    /**
+     * Copy of fixed order coefficients in ShCoefficients
+     * @param coefficients
+     * @return
+     */
+    template<class R, size_t N>
+    ShCoefficients<R> dynamic(const std::array<R, N> &coefficients) {
+        return ShCoefficients<R>(coefficients.begin(), coefficients.end());
+    }
+
+    /**
+     * Decode signal of fixed order at unit direction, loops have constant trip count and are unrolled
+     * @param coefficients (Order + 1)^2 values
+     * @param direction
+     * @return
+     */
+    template<uint16_t Order, class R>
+    R decode(const R *coefficients, const vec3 &direction) {
+        const size_t n = (Order + 1u) * (Order + 1u);
+        real y[n];
+        math::basis<Order>(direction, y);
+        R decoded = coefficients[0] * y[0];
+        for (size_t k = 1; k < n; k++) {
+            decoded += coefficients[k] * y[k];
+        }
+        return decoded;
+    }
+
+    template<class R, size_t N>
+    R decode(const std::array<R, N> &coefficients, const vec3 &direction) {
+        return decode<fixedOrder(N)>(coefficients.data(), direction);
+    }
+
+    /**
+     * Fixed order counterpart of projectCubeMap: texel integrals or closed form basis at texel centers, sums are
+     * kept in arrays
+     * @param cubemap
+     * @return
+     */
+    template<class R, uint16_t Order, class F>
+    ShCoefficientsN<R, Order> projectCubeMap(CubeMap<F> &cubemap) {
+        const size_t n = (Order + 1u) * (Order + 1u);
+        if (!cubemap.isSquare()) {
+            throw std::runtime_error("projectCubeMap: cubemap faces have to be square and of the same size");
+        }
+        const int size = cubemap.getWidth();
+        std::shared_ptr<const TexelIntegrals> integrals;
+        if (TexelIntegrals::affordable((uint16_t) size, Order)) {
+            integrals = TexelIntegrals::get((uint16_t) size, Order);
+        }
+
+        std::map<CubeMapFaceEnum, const F *> faces;
+        for (auto &item : faceTransforms()) {
+            faces[item.first] = cubemap[item.first]->getData();
+        }
+
+        std::array<ShCoefficientsN<R, Order>, symmetry::ELEMENTS> sums;
+        for (auto &sum : sums) {
+            sum.fill(R(0));
+        }
+        real center[n];
+        const real d = 2.0 / size;
+        size_t index = 0;
+        symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+            const real *y = center;
+            if (integrals) {
+                y = (*integrals)(index++);
+            } else {
+                const real s = -1 + d * (orbit.texel.j + 0.5), t = -1 + d * (orbit.texel.i + 0.5);
+                const real dw = solidAngle(std::abs(s), std::abs(t), d, d);
+                math::basis<Order>(orbit.direction, center);
+                for (size_t c = 0; c < n; c++) {
+                    center[c] *= dw;
+                }
+            }
+            for (uint8_t k = 0; k < orbit.size; k++) {
+                const symmetry::Texel &texel = orbit.images[k].texel;
+                const R sample = R(faces[texel.face][texel.i * size + texel.j]);
+                ShCoefficientsN<R, Order> &sum = sums[orbit.images[k].element];
+                for (size_t c = 0; c < n; c++) {
+                    sum[c] += sample * y[c];
+                }
+            }
+        });
+
+        const symmetry::BasisAction action(Order);
+        ShCoefficientsN<R, Order> coefficients;
+        coefficients.fill(R(0));
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t c = 0; c < n; c++) {
+                coefficients[c] += sums[element][action.index(element, c)] * action.sign(element, c);
+            }
+        }
+        return coefficients;
+    }
+}
+
+#endif //SH_FIXEDORDER_H
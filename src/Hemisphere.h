@@ -0,0 +1,231 @@
+#ifndef SH_HEMISPHERE_H
+#define SH_HEMISPHERE_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "ShCoefficients.h"
+#include "TexelIntegrals.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Basis encoded data is projected onto, Hemispherical Harmonics are only decoded by decodeHemisphere()
+     */
+    enum class Basis {
+        Spherical,
+        Hemispherical
+    };
+
+    namespace math {
+
+        /**
+         * Evaluate all Hemispherical Harmonic basis functions up to given order at unit direction of upper (y > 0)
+         * hemisphere. HSH are Spherical Harmonics with cos(tetta) remapped to 2 * cos(tetta) - 1, which stretches
+         * the upper hemisphere over the whole sphere, times sqrt(2) to be orthonormal over the hemisphere.
+         * Functions with m != 0 vanish at the horizon
+         * @param order max band index
+         * @param dir unit direction (OpenGL space)
+         * @param out (order + 1)^2 values, index l * (l + 1) + m
+         */
+        void hemisphericalBasis(int order, const vec3 &dir, real *out) {
+            const real sinTetta = std::sqrt(std::max<real>(0, 1 - dir.y * dir.y));
+            const real cosPhi = sinTetta > 0 ? dir.z / sinTetta : 1;
+            const real sinPhi = sinTetta > 0 ? dir.x / sinTetta : 0;
+            const real x = std::min<real>(1, std::max<real>(-1, 2 * dir.y - 1));
+            const real somx2 = std::sqrt(std::max<real>(0, (1 - x) * (1 + x)));
+            basis(order, vec3(somx2 * sinPhi, x, somx2 * cosPhi), out);
+            const size_t n = (order + 1u) * (order + 1u);
+            for (size_t k = 0; k < n; k++) {
+                out[k] *= SQRT2;
+            }
+        }
+    }
+
+    /**
+     * First row of side faces above the horizon, side face rows go bottom to top along y. Middle row of odd sized
+     * face crosses the horizon
+     * @param size
+     * @return
+     */
+    inline int horizonRow(int size) {
+        return size / 2;
+    }
+
+    /**
+     * Project cubemap of upper hemisphere data: NegativeY face and lower halves of side faces are taken as zero and
+     * skipped, so the walk covers half of texels. Texels are weighted by texel integrals as in projectCubeMap (texel
+     * center rule for faces too large for tables), rows crossing the horizon count half
+     * @param cubemap
+     * @param order
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> projectHemisphere(CubeMap<F> &cubemap, uint16_t order) {
+        const size_t n = (order + 1u) * (order + 1u);
+        if (!cubemap.isSquare()) {
+            throw std::runtime_error("projectHemisphere: cubemap faces have to be square and of the same size");
+        }
+        const int size = cubemap.getWidth();
+        std::shared_ptr<const TexelIntegrals> integrals;
+        std::shared_ptr<const symmetry::TexelOrbits> texelOrbits;
+        if (TexelIntegrals::affordable((uint16_t) size, order)) {
+            integrals = TexelIntegrals::get((uint16_t) size, order);
+            texelOrbits = symmetry::TexelOrbits::get(size);
+        }
+
+        ShCoefficients<R> coefficients(n, R(0));
+        std::vector<ShCoefficients<R>> sums(symmetry::ELEMENTS, ShCoefficients<R>(n, R(0)));
+        std::vector<real> center(n);
+        const real d = 2.0 / size;
+        for (auto &item : faceTransforms()) {
+            if (item.first == CubeMapFaceEnum::NegativeY) {
+                continue;
+            }
+            const bool side = item.first != CubeMapFaceEnum::PositiveY;
+            const F *data = cubemap[item.first]->getData();
+            for (int i = side ? horizonRow(size) : 0; i < size; i++) {
+                const real weight = side && 2 * i + 1 == size ? 0.5 : 1;
+                for (int j = 0; j < size; j++) {
+                    const R sample = R(data[i * size + j]) * weight;
+                    if (integrals) {
+                        const real *y = (*integrals)(texelOrbits->orbit(item.first, i, j));
+                        ShCoefficients<R> &sum = sums[texelOrbits->element(item.first, i, j)];
+                        for (size_t k = 0; k < n; k++) {
+                            sum[k] += sample * y[k];
+                        }
+                    } else {
+                        const real s = -1 + d * (j + 0.5), t = -1 + d * (i + 0.5);
+                        const real dw = solidAngle(std::abs(s), std::abs(t), d, d);
+                        math::basis(order, item.second * glm::normalize(vec3(s, t, -1)), center.data());
+                        for (size_t k = 0; k < n; k++) {
+                            coefficients[k] += sample * (center[k] * dw);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (integrals) {
+            const symmetry::BasisAction action(order);
+            for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+                for (size_t k = 0; k < n; k++) {
+                    coefficients[k] += sums[element][action.index(element, k)] * action.sign(element, k);
+                }
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Project upper hemisphere of cubemap onto Hemispherical Harmonics, see math::hemisphericalBasis(). Texels above
+     * the horizon are weighted by solid angle at texel centers
+     * @param cubemap
+     * @param order
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> projectHemisphericalHarmonics(CubeMap<F> &cubemap, uint16_t order) {
+        const size_t n = (order + 1u) * (order + 1u);
+        if (!cubemap.isSquare()) {
+            throw std::runtime_error("projectHemisphericalHarmonics: cubemap faces have to be square and of the same size");
+        }
+        const int size = cubemap.getWidth();
+        ShCoefficients<R> coefficients(n, R(0));
+        std::vector<real> y(n);
+        const real d = 2.0 / size;
+        for (auto &item : faceTransforms()) {
+            if (item.first == CubeMapFaceEnum::NegativeY) {
+                continue;
+            }
+            const bool side = item.first != CubeMapFaceEnum::PositiveY;
+            const F *data = cubemap[item.first]->getData();
+            for (int i = side ? horizonRow(size) : 0; i < size; i++) {
+                const real weight = side && 2 * i + 1 == size ? 0.5 : 1;
+                for (int j = 0; j < size; j++) {
+                    const real s = -1 + d * (j + 0.5), t = -1 + d * (i + 0.5);
+                    const real dw = solidAngle(std::abs(s), std::abs(t), d, d) * weight;
+                    math::hemisphericalBasis(order, item.second * glm::normalize(vec3(s, t, -1)), y.data());
+                    const R sample = R(data[i * size + j]);
+                    for (size_t k = 0; k < n; k++) {
+                        coefficients[k] += sample * (y[k] * dw);
+                    }
+                }
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Get signal encoded with Hemispherical Harmonics at unit direction, zero below the horizon
+     * @param coefficients
+     * @param direction
+     * @return
+     */
+    template<class R>
+    R decodeHemisphere(const ShCoefficients<R> &coefficients, const vec3 &direction) {
+        if (direction.y < 0) {
+            return R(0);
+        }
+        std::vector<real> y(coefficients.size());
+        math::hemisphericalBasis(order(coefficients), direction, y.data());
+        R decoded(0);
+        for (size_t k = 0; k < coefficients.size(); k++) {
+            decoded += coefficients[k] * y[k];
+        }
+        return decoded;
+    }
+
+    /**
+     * Convert signal encoded with Hemispherical Harmonics into cubemap, texels below the horizon are zero
+     * @tparam F
+     * @param coefficients
+     * @param size
+     * @return
+     */
+    template<class R, class F>
+    std::shared_ptr<CubeMap<F>> decodeHemisphere(const ShCoefficients<R> &coefficients, int size) {
+        using namespace std;
+
+        map<CubeMapFaceEnum, shared_ptr<PixelArray<F>>> faces;
+        vector<real> y(coefficients.size());
+        const real d = 2.0 / size;
+        for (auto &item : faceTransforms()) {
+            F *data = new F[size * size];
+            faces[item.first] = make_shared<PixelArray<F>>(data, size, size);
+            for (int i = 0; i < size; i++) {
+                for (int j = 0; j < size; j++) {
+                    const vec3 direction = item.second *
+                                           glm::normalize(vec3(-1 + d * (j + 0.5), -1 + d * (i + 0.5), -1));
+                    R value(0);
+                    if (direction.y >= 0) {
+                        math::hemisphericalBasis(order(coefficients), direction, y.data());
+                        for (size_t k = 0; k < coefficients.size(); k++) {
+                            value += coefficients[k] * y[k];
+                        }
+                    }
+                    data[i * size + j] = F(value);
+                }
+            }
+        }
+        return make_shared<CubeMap<F>>(
+                faces[CubeMapFaceEnum::PositiveX],
+                faces[CubeMapFaceEnum::NegativeX],
+                faces[CubeMapFaceEnum::PositiveY],
+                faces[CubeMapFaceEnum::NegativeY],
+                faces[CubeMapFaceEnum::PositiveZ],
+                faces[CubeMapFaceEnum::NegativeZ]);
+    }
+}
+
+#endif //SH_HEMISPHERE_H
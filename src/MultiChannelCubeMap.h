@@ -0,0 +1,193 @@
+#ifndef SH_MULTICHANNELCUBEMAP_H
+#define SH_MULTICHANNELCUBEMAP_H
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "TexelIntegrals.h"
+#include "TexelBasis.h"
+#include "CubeMapSymmetry.h"
+#include "PlanarCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Cubemap with arbitrary amount of float channels (visibility, depth, spectral bins...). Channels of a texel are
+     * stored together, face after face in CubeMapFaceEnum order, rows bottom to top as in CubeMap
+     */
+    class MultiChannelCubeMap {
+    protected:
+        int size;
+        uint16_t channels;
+        std::vector<float> data;
+
+    public:
+        MultiChannelCubeMap(int size, uint16_t channels) :
+                size(size), channels(channels), data(6u * size * size * channels, 0) {}
+
+        int getSize() const {
+            return size;
+        }
+
+        uint16_t getChannels() const {
+            return channels;
+        }
+
+        /**
+         * Channels of texel
+         * @param face
+         * @param i row
+         * @param j column
+         * @return getChannels() values
+         */
+        float *texel(CubeMapFaceEnum face, int i, int j) {
+            return &data[(((size_t) face * size + i) * size + j) * channels];
+        }
+
+        const float *texel(CubeMapFaceEnum face, int i, int j) const {
+            return &data[(((size_t) face * size + i) * size + j) * channels];
+        }
+    };
+
+    /**
+     * Project every channel of the cubemap. Texels are weighted by texel integrals as in projectCubeMap (texel
+     * center rule for faces too large for tables). Sums are kept coefficient by coefficient with channels innermost,
+     * so accumulation of a texel is vectorized over channels and wide texels cost little more than RGB
+     * @param cubemap
+     * @param order
+     * @return
+     */
+    PlanarCoefficients projectChannels(const MultiChannelCubeMap &cubemap, uint16_t order) {
+        const size_t n = (order + 1u) * (order + 1u);
+        const size_t channels = cubemap.getChannels();
+        const int size = cubemap.getSize();
+        const size_t width = n * channels;
+
+        std::vector<real> sums(symmetry::ELEMENTS * width, 0);
+        std::vector<real> sample(channels);
+        if (TexelIntegrals::affordable((uint16_t) size, order)) {
+            const auto integrals = TexelIntegrals::get((uint16_t) size, order);
+            const auto texelOrbits = symmetry::TexelOrbits::get(size);
+            for (auto &item : faceTransforms()) {
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        const float *texel = cubemap.texel(item.first, i, j);
+                        std::copy(texel, texel + channels, sample.begin());
+                        const real *y = (*integrals)(texelOrbits->orbit(item.first, i, j));
+                        real *sum = &sums[texelOrbits->element(item.first, i, j) * width];
+                        for (size_t k = 0; k < n; k++) {
+                            real *row = sum + k * channels;
+                            for (size_t c = 0; c < channels; c++) {
+                                row[c] += y[k] * sample[c];
+                            }
+                        }
+                    }
+                }
+            }
+        } else {
+            // no symmetry tables: everything is gathered by identity element
+            std::vector<real> y(n);
+            const real d = 2.0 / size;
+            for (auto &item : faceTransforms()) {
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        const real s = -1 + d * (j + 0.5), t = -1 + d * (i + 0.5);
+                        const real dw = solidAngle(std::abs(s), std::abs(t), d, d);
+                        math::basis(order, item.second * glm::normalize(vec3(s, t, -1)), y.data());
+                        const float *texel = cubemap.texel(item.first, i, j);
+                        for (size_t c = 0; c < channels; c++) {
+                            sample[c] = texel[c] * dw;
+                        }
+                        for (size_t k = 0; k < n; k++) {
+                            real *row = &sums[k * channels];
+                            for (size_t c = 0; c < channels; c++) {
+                                row[c] += y[k] * sample[c];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        const symmetry::BasisAction action(order);
+        PlanarCoefficients coefficients(cubemap.getChannels(), order);
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            const real *sum = &sums[element * width];
+            for (size_t k = 0; k < n; k++) {
+                const real *row = sum + action.index(element, k) * channels;
+                const real sign = action.sign(element, k);
+                for (uint16_t c = 0; c < channels; c++) {
+                    coefficients(c, k) += row[c] * sign;
+                }
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Convert every channel of encoded signal into cubemap channel, see projectChannels() for the layout of work
+     * @param coefficients
+     * @param size
+     * @return
+     */
+    MultiChannelCubeMap decodeChannels(const PlanarCoefficients &coefficients, int size) {
+        const size_t n = coefficients.size();
+        const uint16_t order = coefficients.getOrder();
+        const size_t channels = coefficients.getChannels();
+        const size_t width = n * channels;
+        MultiChannelCubeMap cubemap(size, coefficients.getChannels());
+
+        // y(k, g(d)) = sign * y(index, d): coefficients moved by every group element, channels innermost
+        const symmetry::BasisAction action(order);
+        std::vector<real> moved(symmetry::ELEMENTS * width, 0);
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t k = 0; k < n; k++) {
+                real *row = &moved[element * width + action.index(element, k) * channels];
+                for (uint16_t c = 0; c < channels; c++) {
+                    row[c] = coefficients(c, k) * action.sign(element, k);
+                }
+            }
+        }
+
+        std::shared_ptr<const TexelBasis> basis;
+        if (TexelBasis::affordable((uint16_t) size, order)) {
+            basis = TexelBasis::get((uint16_t) size, order);
+        }
+        std::vector<real> center(n), value(channels);
+        size_t index = 0;
+        symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+            const real *y = center.data();
+            if (basis) {
+                y = (*basis)(index++);
+            } else {
+                math::basis(order, orbit.direction, center.data());
+            }
+            for (uint8_t i = 0; i < orbit.size; i++) {
+                const symmetry::Texel &texel = orbit.images[i].texel;
+                const real *c = &moved[orbit.images[i].element * width];
+                std::fill(value.begin(), value.end(), 0);
+                for (size_t k = 0; k < n; k++) {
+                    const real *row = c + k * channels;
+                    for (size_t ch = 0; ch < channels; ch++) {
+                        value[ch] += y[k] * row[ch];
+                    }
+                }
+                float *out = cubemap.texel(texel.face, texel.i, texel.j);
+                for (size_t ch = 0; ch < channels; ch++) {
+                    out[ch] = (float) value[ch];
+                }
+            }
+        });
+        return cubemap;
+    }
+}
+
+#endif //SH_MULTICHANNELCUBEMAP_H
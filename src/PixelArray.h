@@ -54,6 +54,10 @@ namespace sh {
             return data;
         }
 
+        T *getData() {
+            return data;
+        }
+
         uint16_t getWidth() const {
             return width;
         }
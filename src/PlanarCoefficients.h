@@ -0,0 +1,380 @@
+#ifndef SH_PLANARCOEFFICIENTS_H
+#define SH_PLANARCOEFFICIENTS_H
+
+#include <vector>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+
+#include "real.h"
+#include "pixel_format.h"
+#include "ShCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Allocator of storage aligned to ALIGNMENT bytes, so vectorized loops start on cache line boundary
+     */
+    template<class T>
+    struct AlignedAllocator {
+        using value_type = T;
+        static const size_t ALIGNMENT = 64;
+
+        AlignedAllocator() = default;
+
+        template<class U>
+        AlignedAllocator(const AlignedAllocator<U> &) {}
+
+        T *allocate(size_t n) {
+            // original pointer is kept right before the aligned block
+            char *raw = static_cast<char *>(::operator new(n * sizeof(T) + ALIGNMENT + sizeof(void *)));
+            const uintptr_t start = reinterpret_cast<uintptr_t>(raw + sizeof(void *));
+            char *aligned = raw + sizeof(void *) + (ALIGNMENT - start % ALIGNMENT) % ALIGNMENT;
+            reinterpret_cast<void **>(aligned)[-1] = raw;
+            return reinterpret_cast<T *>(aligned);
+        }
+
+        void deallocate(T *p, size_t) {
+            ::operator delete(reinterpret_cast<void **>(p)[-1]);
+        }
+
+        template<class U>
+        bool operator==(const AlignedAllocator<U> &) const {
+            return true;
+        }
+
+        template<class U>
+        bool operator!=(const AlignedAllocator<U> &) const {
+            return false;
+        }
+    };
+
+    /**
+     * Coefficients stored channel by channel: every channel is a contiguous aligned plane of (order + 1)^2 reals,
+     * padded to whole cache lines. Unlike ShCoefficients of RGB structs, operations run over planes of plain reals
+     * and are vectorized by compiler. Channel count isn't limited to color
+     */
+    class PlanarCoefficients {
+    protected:
+        uint16_t channels;
+        uint16_t order;
+        size_t count;
+        size_t stride;
+        std::vector<real, AlignedAllocator<real>> data;
+
+    public:
+        static const size_t LANE = AlignedAllocator<real>::ALIGNMENT / sizeof(real);
+
+        PlanarCoefficients() : PlanarCoefficients(0, 0) {}
+
+        /**
+         * Zero coefficients
+         * @param channels
+         * @param order max band index
+         */
+        PlanarCoefficients(uint16_t channels, uint16_t order) :
+                channels(channels), order(order), count((order + 1u) * (order + 1u)),
+                stride((count + LANE - 1) / LANE * LANE), data(channels * stride, 0) {}
+
+        uint16_t getChannels() const {
+            return channels;
+        }
+
+        uint16_t getOrder() const {
+            return order;
+        }
+
+        /**
+         * Amount of coefficients per channel
+         * @return
+         */
+        size_t size() const {
+            return count;
+        }
+
+        /**
+         * Distance between planes in reals, planes are padded with zeros
+         * @return
+         */
+        size_t getStride() const {
+            return stride;
+        }
+
+        real *channel(uint16_t c) {
+            return data.data() + c * stride;
+        }
+
+        const real *channel(uint16_t c) const {
+            return data.data() + c * stride;
+        }
+
+        real &operator()(uint16_t c, size_t k) {
+            return data[c * stride + k];
+        }
+
+        real operator()(uint16_t c, size_t k) const {
+            return data[c * stride + k];
+        }
+
+        /**
+         * Whole storage including padding, channels * stride reals
+         * @return
+         */
+        real *getData() {
+            return data.data();
+        }
+
+        const real *getData() const {
+            return data.data();
+        }
+
+        bool compatible(const PlanarCoefficients &other) const {
+            return channels == other.channels && order == other.order;
+        }
+    };
+
+    namespace planar {
+
+        void check(const PlanarCoefficients &a, const PlanarCoefficients &b) {
+            if (!a.compatible(b)) {
+                throw std::runtime_error("PlanarCoefficients: channels or order mismatch");
+            }
+        }
+
+        PlanarCoefficients from(const ShCoefficients<RGB> &coefficients) {
+            PlanarCoefficients planar(3, order(coefficients));
+            real *r = planar.channel(0), *g = planar.channel(1), *b = planar.channel(2);
+            for (size_t k = 0; k < planar.size(); k++) {
+                r[k] = coefficients[k].r;
+                g[k] = coefficients[k].g;
+                b[k] = coefficients[k].b;
+            }
+            return planar;
+        }
+
+        PlanarCoefficients from(const ShCoefficients<RGBA> &coefficients) {
+            PlanarCoefficients planar(4, order(coefficients));
+            real *r = planar.channel(0), *g = planar.channel(1), *b = planar.channel(2), *a = planar.channel(3);
+            for (size_t k = 0; k < planar.size(); k++) {
+                r[k] = coefficients[k].r;
+                g[k] = coefficients[k].g;
+                b[k] = coefficients[k].b;
+                a[k] = coefficients[k].a;
+            }
+            return planar;
+        }
+
+        /**
+         * First three channels as color, missing channels are zero
+         * @param planar
+         * @return
+         */
+        ShCoefficients<RGB> toRgb(const PlanarCoefficients &planar) {
+            ShCoefficients<RGB> coefficients(planar.size(), RGB(0));
+            for (size_t k = 0; k < planar.size(); k++) {
+                coefficients[k] = RGB(planar.getChannels() > 0 ? planar(0, k) : 0,
+                        planar.getChannels() > 1 ? planar(1, k) : 0, planar.getChannels() > 2 ? planar(2, k) : 0);
+            }
+            return coefficients;
+        }
+
+        /**
+         * First four channels as color with alpha, missing channels are zero
+         * @param planar
+         * @return
+         */
+        ShCoefficients<RGBA> toRgba(const PlanarCoefficients &planar) {
+            ShCoefficients<RGBA> coefficients(planar.size(), RGBA(0));
+            for (size_t k = 0; k < planar.size(); k++) {
+                coefficients[k] = RGBA(planar.getChannels() > 0 ? planar(0, k) : 0,
+                        planar.getChannels() > 1 ? planar(1, k) : 0, planar.getChannels() > 2 ? planar(2, k) : 0,
+                        planar.getChannels() > 3 ? planar(3, k) : 0);
+            }
+            return coefficients;
+        }
+
+        /**
+         * y += a * x
+         * @param a
+         * @param x
+         * @param y
+         */
+        void axpy(real a, const PlanarCoefficients &x, PlanarCoefficients &y) {
+            check(x, y);
+            const real *in = x.getData();
+            real *out = y.getData();
+            const size_t n = x.getChannels() * x.getStride();
+            for (size_t i = 0; i < n; i++) {
+                out[i] += a * in[i];
+            }
+        }
+
+        /**
+         * x *= a
+         * @param a
+         * @param x
+         */
+        void scale(real a, PlanarCoefficients &x) {
+            real *out = x.getData();
+            const size_t n = x.getChannels() * x.getStride();
+            for (size_t i = 0; i < n; i++) {
+                out[i] *= a;
+            }
+        }
+
+        /**
+         * out = a + (b - a) * t, out may alias a or b
+         * @param a
+         * @param b
+         * @param t
+         * @param out
+         */
+        void lerp(const PlanarCoefficients &a, const PlanarCoefficients &b, real t, PlanarCoefficients &out) {
+            check(a, b);
+            if (!out.compatible(a)) {
+                out = PlanarCoefficients(a.getChannels(), a.getOrder());
+            }
+            const real *pa = a.getData(), *pb = b.getData();
+            real *po = out.getData();
+            const size_t n = a.getChannels() * a.getStride();
+            for (size_t i = 0; i < n; i++) {
+                po[i] = pa[i] + (pb[i] - pa[i]) * t;
+            }
+        }
+
+        /**
+         * y += a * x for x of the same channels and lower or equal order, bands above order of x are left as they are
+         * @param a
+         * @param x
+         * @param y
+         */
+        void accumulate(real a, const PlanarCoefficients &x, PlanarCoefficients &y) {
+            if (x.getChannels() != y.getChannels() || x.getOrder() > y.getOrder()) {
+                throw std::runtime_error("PlanarCoefficients: channels or order mismatch");
+            }
+            for (uint16_t c = 0; c < x.getChannels(); c++) {
+                const real *in = x.channel(c);
+                real *out = y.channel(c);
+                for (size_t k = 0; k < x.size(); k++) {
+                    out[k] += a * in[k];
+                }
+            }
+        }
+
+        /**
+         * Copy without bands above given order
+         * @param a
+         * @param order must not exceed order of a
+         * @return
+         */
+        PlanarCoefficients truncate(const PlanarCoefficients &a, uint16_t order) {
+            if (order > a.getOrder()) {
+                throw std::runtime_error("PlanarCoefficients: truncation can't raise order");
+            }
+            PlanarCoefficients truncated(a.getChannels(), order);
+            for (uint16_t c = 0; c < a.getChannels(); c++) {
+                std::copy(a.channel(c), a.channel(c) + truncated.size(), truncated.channel(c));
+            }
+            return truncated;
+        }
+
+        /**
+         * out = sum(weights[i] * sources[i]), e.g. blend of probes around a point. Sources may be of different
+         * orders, out has the highest of them and every source adds its own bands only
+         * @param sources
+         * @param weights
+         * @param out must not be one of sources
+         */
+        void blend(const std::vector<const PlanarCoefficients *> &sources, const std::vector<real> &weights,
+                PlanarCoefficients &out) {
+            if (sources.empty() || sources.size() != weights.size()) {
+                throw std::runtime_error("PlanarCoefficients: blend expects a weight per source");
+            }
+            uint16_t order = 0;
+            for (const PlanarCoefficients *source : sources) {
+                order = std::max(order, source->getOrder());
+            }
+            out = PlanarCoefficients(sources[0]->getChannels(), order);
+            // sources of full order are accumulated four at a time to pass over the output less often
+            real *__restrict po = out.getData();
+            const size_t n = out.getChannels() * out.getStride();
+            size_t i = 0;
+            while (i < sources.size()) {
+                if (i + 4 <= sources.size() && sources[i]->compatible(out) && sources[i + 1]->compatible(out) &&
+                    sources[i + 2]->compatible(out) && sources[i + 3]->compatible(out)) {
+                    const real *__restrict p0 = sources[i]->getData(), *__restrict p1 = sources[i + 1]->getData();
+                    const real *__restrict p2 = sources[i + 2]->getData(), *__restrict p3 = sources[i + 3]->getData();
+                    const real w0 = weights[i], w1 = weights[i + 1], w2 = weights[i + 2], w3 = weights[i + 3];
+                    for (size_t k = 0; k < n; k++) {
+                        po[k] += w0 * p0[k] + w1 * p1[k] + w2 * p2[k] + w3 * p3[k];
+                    }
+                    i += 4;
+                } else {
+                    accumulate(weights[i], *sources[i], out);
+                    i++;
+                }
+            }
+        }
+
+        /**
+         * Integral of product of signals per channel
+         * @param a
+         * @param b
+         * @return channels values
+         */
+        std::vector<real> dot(const PlanarCoefficients &a, const PlanarCoefficients &b) {
+            check(a, b);
+            std::vector<real> result(a.getChannels(), 0);
+            for (uint16_t c = 0; c < a.getChannels(); c++) {
+                const real *pa = a.channel(c), *pb = b.channel(c);
+                real sum = 0;
+                for (size_t k = 0; k < a.getStride(); k++) {
+                    sum += pa[k] * pb[k];
+                }
+                result[c] = sum;
+            }
+            return result;
+        }
+
+        /**
+         * Energy of every band per channel, sum of squares of band coefficients
+         * @param a
+         * @return (order + 1) values per channel, channel after channel
+         */
+        std::vector<real> energy(const PlanarCoefficients &a) {
+            std::vector<real> result(a.getChannels() * (a.getOrder() + 1u), 0);
+            for (uint16_t c = 0; c < a.getChannels(); c++) {
+                const real *p = a.channel(c);
+                for (int l = 0; l <= a.getOrder(); l++) {
+                    real sum = 0;
+                    for (size_t k = l * l; k < (l + 1u) * (l + 1u); k++) {
+                        sum += p[k] * p[k];
+                    }
+                    result[c * (a.getOrder() + 1u) + l] = sum;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Clamp every coefficient into [lower, upper]
+         * @param a
+         * @param lower
+         * @param upper
+         */
+        void clamp(PlanarCoefficients &a, real lower, real upper) {
+            for (uint16_t c = 0; c < a.getChannels(); c++) {
+                real *p = a.channel(c);
+                for (size_t k = 0; k < a.size(); k++) {
+                    p[k] = std::min(upper, std::max(lower, p[k]));
+                }
+            }
+        }
+    }
+}
+
+#endif //SH_PLANARCOEFFICIENTS_H
@@ -0,0 +1,123 @@
+#ifndef SH_QUADRATICFORM_H
+#define SH_QUADRATICFORM_H
+
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "ShCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Bands 0..2 of spherical harmonics are polynomials of degree 2 in (x, y, z), so signal of order 2 is
+     * f(n) = transpose(n) * M * n, n = (x, y, z, 1), with symmetric 4x4 matrix M per channel.
+     * Every band may be scaled before M is built: with cosine lobe factors (PI, 2 * PI / 3, PI / 4) the form yields
+     * irradiance (Ramamoorthi, Hanrahan), with unit factors the signal itself. Higher bands are ignored
+     */
+    template<class R>
+    class QuadraticForm {
+    protected:
+        // unique entries of M: xx, yy, zz, ww and doubled off-diagonal xy, xz, yz, xw, yw, zw
+        R xx, yy, zz, ww, xy, xz, yz, xw, yw, zw;
+
+    public:
+        static constexpr real C0 = 0.282094791773878;
+        static constexpr real C1 = 0.488602511902920;
+        static constexpr real C2 = 1.092548430592079;
+        static constexpr real C3 = 0.315391565252520;
+        static constexpr real C4 = 0.546274215296040;
+
+        /**
+         * @param coefficients missing bands are taken as zero, bands above 2 are ignored
+         * @param a0 factor of band 0
+         * @param a1 factor of band 1
+         * @param a2 factor of band 2
+         */
+        explicit QuadraticForm(const ShCoefficients<R> &coefficients, real a0 = 1, real a1 = 1, real a2 = 1) {
+            R c[9];
+            for (size_t k = 0; k < 9; k++) {
+                const real a = k < 1 ? a0 : k < 4 ? a1 : a2;
+                c[k] = k < coefficients.size() ? coefficients[k] * a : R(0);
+            }
+            // y(1,-1) = -C1 x, y(1,0) = C1 y, y(1,1) = -C1 z, y(2,-2) = C2 xz, y(2,-1) = -C2 xy,
+            // y(2,0) = C3 (3 y^2 - 1), y(2,1) = -C2 yz, y(2,2) = C4 (z^2 - x^2)
+            xx = c[8] * -C4;
+            yy = c[6] * (3 * C3);
+            zz = c[8] * C4;
+            ww = c[0] * C0 - c[6] * C3;
+            xy = c[5] * -C2;
+            xz = c[4] * C2;
+            yz = c[7] * -C2;
+            xw = c[1] * -C1;
+            yw = c[2] * C1;
+            zw = c[3] * -C1;
+        }
+
+        /**
+         * Form evaluating irradiance of the order 2 radiance signal
+         * @param coefficients
+         * @return
+         */
+        static QuadraticForm irradiance(const ShCoefficients<R> &coefficients) {
+            return QuadraticForm(coefficients, math::PI, math::PI2 / 3, math::PI / 4);
+        }
+
+        /**
+         * Entry of M
+         * @param i row, 0..3 for x, y, z, w
+         * @param j column
+         * @return
+         */
+        R matrix(int i, int j) const {
+            const int a = std::min(i, j), b = std::max(i, j);
+            if (a == b) {
+                return a == 0 ? xx : a == 1 ? yy : a == 2 ? zz : ww;
+            }
+            const R doubled = a == 0 ? (b == 1 ? xy : b == 2 ? xz : xw) : a == 1 ? (b == 2 ? yz : yw) : zw;
+            return doubled * 0.5;
+        }
+
+        R operator()(const vec3 &n) const {
+            return xx * (n.x * n.x) + yy * (n.y * n.y) + zz * (n.z * n.z) + xy * (n.x * n.y) + xz * (n.x * n.z) +
+                   yz * (n.y * n.z) + xw * n.x + yw * n.y + zw * n.z + ww;
+        }
+
+        /**
+         * Evaluate at many unit directions given as structure of arrays, the loop has no dependencies between
+         * directions, so it is vectorized
+         * @param x
+         * @param y
+         * @param z
+         * @param count
+         * @param out
+         */
+        void operator()(const real *x, const real *y, const real *z, size_t count, R *out) const {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = xx * (x[i] * x[i]) + yy * (y[i] * y[i]) + zz * (z[i] * z[i]) + xy * (x[i] * y[i]) +
+                         xz * (x[i] * z[i]) + yz * (y[i] * z[i]) + xw * x[i] + yw * y[i] + zw * z[i] + ww;
+            }
+        }
+
+        /**
+         * Evaluate at many unit directions given as array of structures
+         * @param directions
+         * @param count
+         * @param out
+         */
+        void operator()(const vec3 *directions, size_t count, R *out) const {
+            for (size_t i = 0; i < count; i++) {
+                out[i] = (*this)(directions[i]);
+            }
+        }
+    };
+
+    template<class R> constexpr real QuadraticForm<R>::C0;
+    template<class R> constexpr real QuadraticForm<R>::C1;
+    template<class R> constexpr real QuadraticForm<R>::C2;
+    template<class R> constexpr real QuadraticForm<R>::C3;
+    template<class R> constexpr real QuadraticForm<R>::C4;
+}
+
+#endif //SH_QUADRATICFORM_H
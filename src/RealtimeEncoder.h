@@ -0,0 +1,172 @@
+#ifndef SH_REALTIMEENCODER_H
+#define SH_REALTIMEENCODER_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "CubeMap.h"
+#include "TexelIntegrals.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Projection of cubemaps of fixed face size and order for per frame use. Tables and workspace are set up once by
+     * constructor, encoding itself allocates nothing and reads faces straight from caller buffers.
+     * Work may be spread over frames: step() walks given amount of face rows (6 * size rows per cubemap), when the
+     * last row is done coefficients are published to the front buffer, which keeps the previous complete result
+     * until then. Nothing is pending until begin(), so step() before it does nothing
+     */
+    template<class R, class F>
+    class RealtimeEncoder {
+    protected:
+        int size;
+        uint16_t order;
+        size_t count;
+        std::shared_ptr<const TexelIntegrals> integrals;
+        std::shared_ptr<const symmetry::TexelOrbits> texelOrbits;
+        // per group element: coefficient c gathers sum[index[c]] * sign[c]
+        std::vector<uint32_t> indices;
+        std::vector<real> signs;
+        std::vector<R> sums;
+        std::vector<R> buffers[2];
+        int front;
+        const F *faces[6];
+        int row;
+
+        void walk(int rows) {
+            const int last = std::min(6 * size, row + rows);
+            for (; row < last; row++) {
+                const CubeMapFaceEnum face = (CubeMapFaceEnum) (row / size);
+                const int i = row % size;
+                const F *data = faces[face] + (size_t) i * size;
+                for (int j = 0; j < size; j++) {
+                    const R sample = R(data[j]);
+                    const real *y = (*integrals)(texelOrbits->orbit(face, i, j));
+                    R *sum = &sums[texelOrbits->element(face, i, j) * count];
+                    for (size_t c = 0; c < count; c++) {
+                        sum[c] += sample * y[c];
+                    }
+                }
+            }
+        }
+
+        void finish(R *out) const {
+            std::fill(out, out + count, R(0));
+            for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+                const R *sum = &sums[element * count];
+                const uint32_t *index = &indices[element * count];
+                const real *sign = &signs[element * count];
+                for (size_t c = 0; c < count; c++) {
+                    out[c] += sum[index[c]] * sign[c];
+                }
+            }
+        }
+
+    public:
+        /**
+         * @param size face size, must be small enough for TexelIntegrals tables
+         * @param order
+         */
+        RealtimeEncoder(int size, uint16_t order) :
+                size(size), order(order), count((order + 1u) * (order + 1u)), front(0), faces(), row(6 * size) {
+            if (size <= 0 || !TexelIntegrals::affordable((uint16_t) size, order)) {
+                throw std::runtime_error("RealtimeEncoder: face size " + std::to_string(size) + " is not supported");
+            }
+            integrals = TexelIntegrals::get((uint16_t) size, order);
+            texelOrbits = symmetry::TexelOrbits::get(size);
+
+            const symmetry::BasisAction action(order);
+            indices.resize(symmetry::ELEMENTS * count);
+            signs.resize(symmetry::ELEMENTS * count);
+            for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+                for (size_t c = 0; c < count; c++) {
+                    indices[element * count + c] = action.index(element, c);
+                    signs[element * count + c] = action.sign(element, c);
+                }
+            }
+            sums.assign(symmetry::ELEMENTS * count, R(0));
+            buffers[0].assign(count, R(0));
+            buffers[1].assign(count, R(0));
+        }
+
+        int getSize() const {
+            return size;
+        }
+
+        uint16_t getOrder() const {
+            return order;
+        }
+
+        /**
+         * Amount of coefficients, (order + 1)^2
+         * @return
+         */
+        size_t getCount() const {
+            return count;
+        }
+
+        /**
+         * Project whole cubemap at once
+         * @param faces size * size texels row by row per face, indexed by CubeMapFaceEnum. Pending sliced encode is
+         * dropped
+         * @param out getCount() coefficients
+         */
+        void encode(const F *const faces[6], R *out) {
+            begin(faces);
+            walk(6 * size);
+            finish(out);
+        }
+
+        /**
+         * Start sliced projection of cubemap, buffers have to stay valid until it's done
+         * @param faces size * size texels row by row per face, indexed by CubeMapFaceEnum
+         */
+        void begin(const F *const faces[6]) {
+            std::copy(faces, faces + 6, this->faces);
+            std::fill(sums.begin(), sums.end(), R(0));
+            row = 0;
+        }
+
+        /**
+         * Walk next face rows of projection started by begin()
+         * @param rows
+         * @return true if cubemap is done and coefficients() are updated
+         */
+        bool step(int rows) {
+            if (row >= 6 * size) {
+                return false;
+            }
+            walk(rows);
+            if (row < 6 * size) {
+                return false;
+            }
+            finish(buffers[1 - front].data());
+            front = 1 - front;
+            return true;
+        }
+
+        /**
+         * Rows left in projection started by begin()
+         * @return
+         */
+        int remaining() const {
+            return 6 * size - row;
+        }
+
+        /**
+         * Coefficients of the last cubemap completed by step()
+         * @return getCount() coefficients
+         */
+        const R *coefficients() const {
+            return buffers[front].data();
+        }
+    };
+}
+
+#endif //SH_REALTIMEENCODER_H
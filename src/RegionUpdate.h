@@ -0,0 +1,89 @@
+#ifndef SH_REGIONUPDATE_H
+#define SH_REGIONUPDATE_H
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "ShCoefficients.h"
+#include "TexelIntegrals.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Rectangle of face texels which changed: rows [i, i + rows) and columns [j, j + columns), texel values before
+     * and after the change are given row by row
+     */
+    template<class F>
+    struct DirtyRegion {
+        CubeMapFaceEnum face;
+        int i;
+        int j;
+        int rows;
+        int columns;
+        const F *previous;
+        const F *current;
+    };
+
+    /**
+     * Projection is linear in texel values, so coefficients of changed cubemap are the previous ones plus projection
+     * of the difference, which is zero outside of dirty regions. Texels are weighted the same way as projectCubeMap
+     * does (integrals of canonical texel moved by group element), so the result matches full projection up to
+     * rounding while the cost is proportional to the dirty area
+     * @param coefficients projection of the cubemap before the change, updated in place
+     * @param size face size of the cubemap
+     * @param regions
+     */
+    template<class R, class F>
+    void update(ShCoefficients<R> &coefficients, int size, const std::vector<DirtyRegion<F>> &regions) {
+        const uint16_t order = sh::order(coefficients);
+        const size_t n = (order + 1u) * (order + 1u);
+        std::shared_ptr<const TexelIntegrals> integrals;
+        std::shared_ptr<const symmetry::TexelOrbits> texelOrbits;
+        if (TexelIntegrals::affordable((uint16_t) size, order)) {
+            integrals = TexelIntegrals::get((uint16_t) size, order);
+            texelOrbits = symmetry::TexelOrbits::get(size);
+        }
+        const symmetry::BasisAction action(order);
+
+        std::vector<real> center(n);
+        const real d = 2.0 / size;
+        for (const DirtyRegion<F> &region : regions) {
+            if (region.i < 0 || region.j < 0 || region.i + region.rows > size || region.j + region.columns > size) {
+                throw std::runtime_error("update: dirty region exceeds face of size " + std::to_string(size));
+            }
+            const mat3 &transform = faceTransforms().at(region.face);
+            for (int r = 0; r < region.rows; r++) {
+                for (int c = 0; c < region.columns; c++) {
+                    const int i = region.i + r, j = region.j + c;
+                    const size_t at = (size_t) r * region.columns + c;
+                    const R delta = R(region.current[at]) - R(region.previous[at]);
+                    if (integrals) {
+                        const real *y = (*integrals)(texelOrbits->orbit(region.face, i, j));
+                        const uint8_t element = texelOrbits->element(region.face, i, j);
+                        for (size_t k = 0; k < n; k++) {
+                            coefficients[k] += delta * (y[action.index(element, k)] * action.sign(element, k));
+                        }
+                    } else {
+                        const real s = -1 + d * (j + 0.5), t = -1 + d * (i + 0.5);
+                        const real dw = solidAngle(std::abs(s), std::abs(t), d, d);
+                        math::basis(order, transform * glm::normalize(vec3(s, t, -1)), center.data());
+                        for (size_t k = 0; k < n; k++) {
+                            coefficients[k] += delta * (center[k] * dw);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif //SH_REGIONUPDATE_H
@@ -0,0 +1,18 @@
+#ifndef SH_SHCOEFFICIENTS_H
+#define SH_SHCOEFFICIENTS_H
+
+#include <vector>
+#include <cmath>
+#include <inttypes.h>
+
+namespace sh {
+
+    template<class R>
+    using ShCoefficients = std::vector<R>;
+
+    template<class R>
+    uint16_t order(const ShCoefficients<R> &coefficients) {
+        return (uint16_t) (std::sqrt(coefficients.size()) - 1u);
+    }
+}
+#endif //SH_SHCOEFFICIENTS_H
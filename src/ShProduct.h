@@ -0,0 +1,204 @@
+#ifndef SH_SHPRODUCT_H
+#define SH_SHPRODUCT_H
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "ShCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Coupling (Gaunt) coefficients of real spherical harmonics: G(i, j, k) = integral(y(i) * y(j) * y(k)) over the
+     * sphere, so the product of signals f and g projected to basis function k is sum(G(i, j, k) * f(i) * g(j)).
+     * The tensor is sparse: band l3 couples to l1, l2 only if |l1 - l2| <= l3 <= l1 + l2 and l1 + l2 + l3 is even,
+     * and |m3| is either |m1| + |m2| or ||m1| - |m2||. Candidate entries are integrated exactly by quadrature, since
+     * the integrand is a polynomial of degree l1 + l2 + l3, and only nonzero ones are kept grouped by output.
+     * Tables depend on orders only and are built once, see get()
+     */
+    class CouplingTensor {
+    protected:
+        uint16_t order1;
+        uint16_t order2;
+        uint16_t order3;
+        // entries of output k are [offsets[k], offsets[k + 1]) of the arrays below
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> second;
+        std::vector<real> values;
+
+    public:
+        /**
+         * @param order1 max band index of the first factor
+         * @param order2 max band index of the second factor
+         * @param order3 max band index of the product
+         */
+        CouplingTensor(uint16_t order1, uint16_t order2, uint16_t order3) :
+                order1(order1), order2(order2), order3(order3) {
+            // candidates sorted by output, then by factors
+            std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> candidates;
+            for (int l1 = 0; l1 <= order1; l1++) {
+                for (int m1 = -l1; m1 <= l1; m1++) {
+                    for (int l2 = 0; l2 <= order2; l2++) {
+                        for (int m2 = -l2; m2 <= l2; m2++) {
+                            const int a1 = std::abs(m1), a2 = std::abs(m2);
+                            for (int l3 = std::abs(l1 - l2); l3 <= std::min<int>(l1 + l2, order3); l3 += 2) {
+                                for (int m3 : {a1 + a2, -(a1 + a2), a1 - a2, a2 - a1}) {
+                                    if (std::abs(m3) <= l3) {
+                                        candidates.emplace_back(l3 * (l3 + 1) + m3, l1 * (l1 + 1) + m1,
+                                                l2 * (l2 + 1) + m2);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            // Gauss-Legendre in y = cos(tetta) and uniform rule in phi are exact up to degree l1 + l2 + l3
+            const int degree = order1 + order2 + order3;
+            std::vector<real> nodes, weights;
+            math::gaussLegendre(degree / 2 + 1, nodes, weights);
+            const int steps = degree + 1;
+            const int order = std::max(order1, std::max(order2, order3));
+            std::vector<real> y((order + 1u) * (order + 1u));
+            std::vector<real> integrals(candidates.size(), 0);
+            for (size_t a = 0; a < nodes.size(); a++) {
+                const real sinTetta = std::sqrt(std::max<real>(0, 1 - nodes[a] * nodes[a]));
+                for (int b = 0; b < steps; b++) {
+                    const real phi = math::PI2 * b / steps;
+                    const real w = weights[a] * math::PI2 / steps;
+                    math::basis(order, vec3(sinTetta * std::sin(phi), nodes[a], sinTetta * std::cos(phi)), y.data());
+                    for (size_t c = 0; c < candidates.size(); c++) {
+                        integrals[c] += w * y[std::get<0>(candidates[c])] * y[std::get<1>(candidates[c])] *
+                                        y[std::get<2>(candidates[c])];
+                    }
+                }
+            }
+
+            const size_t outputs = (order3 + 1u) * (order3 + 1u);
+            offsets.assign(outputs + 1, 0);
+            for (size_t c = 0; c < candidates.size(); c++) {
+                if (std::abs(integrals[c]) > 1e-10) {
+                    offsets[std::get<0>(candidates[c]) + 1]++;
+                    first.push_back(std::get<1>(candidates[c]));
+                    second.push_back(std::get<2>(candidates[c]));
+                    values.push_back(integrals[c]);
+                }
+            }
+            for (size_t k = 0; k < outputs; k++) {
+                offsets[k + 1] += offsets[k];
+            }
+        }
+
+        uint16_t getOrder1() const {
+            return order1;
+        }
+
+        uint16_t getOrder2() const {
+            return order2;
+        }
+
+        uint16_t getOrder3() const {
+            return order3;
+        }
+
+        /**
+         * Amount of nonzero coupling coefficients
+         * @return
+         */
+        size_t size() const {
+            return values.size();
+        }
+
+        /**
+         * Coupling coefficient of basis functions i, j and k, zero if it isn't stored
+         * @param i
+         * @param j
+         * @param k
+         * @return
+         */
+        real operator()(uint32_t i, uint32_t j, uint32_t k) const {
+            for (uint32_t e = offsets[k]; e < offsets[k + 1]; e++) {
+                if (first[e] == i && second[e] == j) {
+                    return values[e];
+                }
+            }
+            return 0;
+        }
+
+        /**
+         * Project product of two signals, coefficients missing from factors are taken as zero.
+         * Second factor may be single channel (visibility, transfer) or of the same type as the first one
+         * @param f
+         * @param g
+         * @return coefficients of order order3
+         */
+        template<class R, class S>
+        ShCoefficients<R> operator()(const ShCoefficients<R> &f, const ShCoefficients<S> &g) const {
+            const size_t size1 = (order1 + 1u) * (order1 + 1u), size2 = (order2 + 1u) * (order2 + 1u);
+            if (f.size() < size1 || g.size() < size2) {
+                ShCoefficients<R> paddedF(f);
+                ShCoefficients<S> paddedG(g);
+                paddedF.resize(std::max(size1, f.size()), R(0));
+                paddedG.resize(std::max(size2, g.size()), S(0));
+                return (*this)(paddedF, paddedG);
+            }
+
+            const size_t outputs = offsets.size() - 1;
+            ShCoefficients<R> product(outputs);
+            for (size_t k = 0; k < outputs; k++) {
+                R sum(0);
+                for (uint32_t e = offsets[k]; e < offsets[k + 1]; e++) {
+                    sum += f[first[e]] * (g[second[e]] * values[e]);
+                }
+                product[k] = sum;
+            }
+            return product;
+        }
+
+        /**
+         * Shared tensor for (order1, order2, order3), built on first request
+         * @param order1
+         * @param order2
+         * @param order3
+         * @return
+         */
+        static std::shared_ptr<const CouplingTensor> get(uint16_t order1, uint16_t order2, uint16_t order3) {
+            static std::mutex mutex;
+            static std::map<std::tuple<uint16_t, uint16_t, uint16_t>, std::shared_ptr<const CouplingTensor>> cache;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &tensor = cache[std::make_tuple(order1, order2, order3)];
+            if (!tensor) {
+                tensor = std::make_shared<const CouplingTensor>(order1, order2, order3);
+            }
+            return tensor;
+        }
+    };
+
+    /**
+     * Project product of two signals to given order, e.g. radiance by visibility
+     * @param f
+     * @param g
+     * @param order max band index of the product
+     * @return
+     */
+    template<class R, class S>
+    ShCoefficients<R> product(const ShCoefficients<R> &f, const ShCoefficients<S> &g, uint16_t order) {
+        return (*CouplingTensor::get(sh::order(f), sh::order(g), order))(f, g);
+    }
+}
+
+#endif //SH_SHPRODUCT_H
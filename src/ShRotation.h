@@ -0,0 +1,198 @@
+#ifndef SH_SHROTATION_H
+#define SH_SHROTATION_H
+
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <inttypes.h>
+
+#include "real.h"
+#include "ShCoefficients.h"
+#include "parallel.h"
+
+namespace sh {
+
+    /**
+     * Rotation of spherical harmonic coefficients. Rotation keeps bands apart, so it is a block diagonal matrix with
+     * (2l + 1) x (2l + 1) block per band. Blocks are built recursively from band 1 (Ivanic, Ruedenberg with errata)
+     * in time proportional to the amount of their entries.
+     * The recursion is formulated for basis without Condon-Shortley phase and with polar axis z, basis of this
+     * library differs from it by sign (-1)^m and by the cyclic permutation of axes (x, y, z) -> (z, x, y)
+     */
+    class ShRotation {
+    protected:
+        uint16_t order;
+        std::vector<std::vector<real>> bands;
+
+        static real get(const std::vector<real> &band, int l, int m, int n) {
+            return band[(m + l) * (2 * l + 1) + n + l];
+        }
+
+        real p(int i, int a, int b, int l) const {
+            const std::vector<real> &r1 = bands[1], &previous = bands[l - 1];
+            if (b == l) {
+                return get(r1, 1, i, 1) * get(previous, l - 1, a, l - 1) -
+                       get(r1, 1, i, -1) * get(previous, l - 1, a, -l + 1);
+            } else if (b == -l) {
+                return get(r1, 1, i, 1) * get(previous, l - 1, a, -l + 1) +
+                       get(r1, 1, i, -1) * get(previous, l - 1, a, l - 1);
+            }
+            return get(r1, 1, i, 0) * get(previous, l - 1, a, b);
+        }
+
+        real u(int m, int n, int l) const {
+            return p(0, m, n, l);
+        }
+
+        real v(int m, int n, int l) const {
+            if (m == 0) {
+                return p(1, 1, n, l) + p(-1, -1, n, l);
+            } else if (m > 0) {
+                return m == 1 ? p(1, 0, n, l) * std::sqrt(2.0) : p(1, m - 1, n, l) - p(-1, -m + 1, n, l);
+            }
+            return m == -1 ? p(-1, 0, n, l) * std::sqrt(2.0) : p(1, m + 1, n, l) + p(-1, -m - 1, n, l);
+        }
+
+        real w(int m, int n, int l) const {
+            if (m > 0) {
+                return p(1, m + 1, n, l) + p(-1, -m - 1, n, l);
+            }
+            return p(1, m - 1, n, l) - p(-1, -m + 1, n, l);
+        }
+
+    public:
+        /**
+         * @param rotation rotation applied to the signal: rotated(d) = signal(transpose(rotation) * d)
+         * @param order max band index
+         */
+        ShRotation(const mat3 &rotation, uint16_t order) : order(order), bands(order + 1u) {
+            bands[0] = {1};
+            if (order == 0) {
+                return;
+            }
+
+            // rotation in the frame of the recursion, axes (x', y', z') = (z, x, y); band 1 is ordered (y', z', x')
+            const int axis[3] = {2, 0, 1};
+            auto r = [&rotation, &axis](int i, int j) -> real {
+                return rotation[axis[j]][axis[i]];
+            };
+            bands[1] = {
+                    r(1, 1), r(1, 2), r(1, 0),
+                    r(2, 1), r(2, 2), r(2, 0),
+                    r(0, 1), r(0, 2), r(0, 0)
+            };
+
+            for (int l = 2; l <= order; l++) {
+                std::vector<real> &band = bands[l];
+                band.resize((2 * l + 1) * (2 * l + 1));
+                for (int m = -l; m <= l; m++) {
+                    for (int n = -l; n <= l; n++) {
+                        const int d = m == 0 ? 1 : 0;
+                        const real denominator = std::abs(n) < l ? (l + n) * (l - n) : (2 * l) * (2 * l - 1);
+                        const real uu = std::sqrt((l + m) * (l - m) / denominator);
+                        const real vv = 0.5 * std::sqrt((1 + d) * (l + std::abs(m) - 1.0) * (l + std::abs(m)) /
+                                                        denominator) * (1 - 2 * d);
+                        const real ww = -0.5 * std::sqrt((l - std::abs(m) - 1.0) * (l - std::abs(m)) / denominator) *
+                                        (1 - d);
+                        real value = 0;
+                        if (uu != 0) {
+                            value += uu * u(m, n, l);
+                        }
+                        if (vv != 0) {
+                            value += vv * v(m, n, l);
+                        }
+                        if (ww != 0) {
+                            value += ww * w(m, n, l);
+                        }
+                        band[(m + l) * (2 * l + 1) + n + l] = value;
+                    }
+                }
+            }
+
+            // Condon-Shortley phase: conjugate every block with diag((-1)^m)
+            for (int l = 1; l <= order; l++) {
+                for (int m = -l; m <= l; m++) {
+                    for (int n = -l; n <= l; n++) {
+                        if ((m + n) % 2) {
+                            bands[l][(m + l) * (2 * l + 1) + n + l] *= -1;
+                        }
+                    }
+                }
+            }
+        }
+
+        uint16_t getOrder() const {
+            return order;
+        }
+
+        /**
+         * Block of band l, row major, entry (m, n) at (m + l) * (2l + 1) + n + l
+         * @param l
+         * @return
+         */
+        const std::vector<real> &band(int l) const {
+            return bands[l];
+        }
+
+        /**
+         * Rotate coefficients into out
+         * @param coefficients order must not exceed the order of rotation
+         * @param out must not alias coefficients
+         */
+        template<class R>
+        void apply(const R *coefficients, size_t size, R *out) const {
+            const int n = (int) std::lround(std::sqrt((real) size)) - 1;
+            if (n > order) {
+                throw std::runtime_error("ShRotation: coefficients of order " + std::to_string(n) +
+                                         " exceed order of rotation " + std::to_string(order));
+            }
+            for (int l = 0; l <= n; l++) {
+                const int first = l * l, width = 2 * l + 1;
+                const real *block = bands[l].data();
+                for (int m = 0; m < width; m++) {
+                    R sum(0);
+                    for (int k = 0; k < width; k++) {
+                        sum += coefficients[first + k] * block[m * width + k];
+                    }
+                    out[first + m] = sum;
+                }
+            }
+        }
+
+        template<class R>
+        ShCoefficients<R> operator()(const ShCoefficients<R> &coefficients) const {
+            ShCoefficients<R> rotated(coefficients.size());
+            apply(coefficients.data(), coefficients.size(), rotated.data());
+            return rotated;
+        }
+
+        /**
+         * Rotate many coefficient sets by the same rotation, sets are spread over threads
+         * @param coefficients orders must not exceed the order of rotation
+         * @param threads amount of chunks, 0 - threads of the shared pool
+         * @return
+         */
+        template<class R>
+        std::vector<ShCoefficients<R>> operator()(const std::vector<ShCoefficients<R>> &coefficients,
+                unsigned threads = 0) const {
+            for (const auto &set : coefficients) {
+                if (sh::order(set) > order) {
+                    throw std::runtime_error("ShRotation: coefficients of order " + std::to_string(sh::order(set)) +
+                                             " exceed order of rotation " + std::to_string(order));
+                }
+            }
+            std::vector<ShCoefficients<R>> rotated(coefficients.size());
+            parallelFor(coefficients.size(), threads, 256, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    rotated[i].resize(coefficients[i].size());
+                    apply(coefficients[i].data(), coefficients[i].size(), rotated[i].data());
+                }
+            });
+            return rotated;
+        }
+    };
+}
+
+#endif //SH_SHROTATION_H
@@ -0,0 +1,94 @@
+#ifndef SH_SPHERICALTRANSFORM_H
+#define SH_SPHERICALTRANSFORM_H
+
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "fft.h"
+#include "ShCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Fast spherical harmonic transform on a Gauss-Legendre grid.
+     * Signal is sampled on rings of constant tetta placed at Gauss-Legendre nodes of cos(tetta), every ring is
+     * transformed along phi with real FFT, then each harmonic m is projected onto the normalized Legendre polynomials
+     * of the ring. Costs O(N^2 log N + L^3) instead of O(L^2 * N^2) of per coefficient integration.
+     * Tables depend on (order, divisions) only, so one instance may encode any number of signals
+     */
+    template<class R>
+    class SphericalTransform {
+    protected:
+        uint16_t order;
+        size_t rings;
+        size_t ringSamples;
+        std::vector<real> tettas;
+        std::vector<real> weights;
+        std::vector<real> legendre;
+    public:
+        /**
+         * @param order max band index
+         * @param divisions requested amount of phi samples per ring. Grid is grown to resolve the given order exactly:
+         * at least order + 1 rings and 2 * order + 2 samples per ring (rounded up to power of two)
+         */
+        SphericalTransform(uint16_t order, uint16_t divisions) : order(order) {
+            rings = std::max<size_t>(divisions / 2, order + 1u);
+            ringSamples = fft::nextPowerOfTwo(std::max<size_t>(std::max<size_t>(divisions, 2u * order + 2u), 2u));
+
+            std::vector<real> nodes;
+            math::gaussLegendre((int) rings, nodes, weights);
+
+            const size_t stride = math::legendreIndex(order, order) + 1u;
+            tettas.resize(rings);
+            legendre.resize(rings * stride);
+            for (size_t j = 0; j < rings; j++) {
+                tettas[j] = std::acos(nodes[j]);
+                math::legendre(order, nodes[j], &legendre[j * stride]);
+            }
+        }
+
+        /**
+         * Number of polar function evaluations per transform
+         * @return
+         */
+        size_t samples() const {
+            return rings * ringSamples;
+        }
+
+        template<class F>
+        ShCoefficients<R> operator()(F &&polarFunction) const {
+            const size_t stride = math::legendreIndex(order, order) + 1u;
+            const real dPhi = math::PI2 / ringSamples;
+
+            ShCoefficients<R> coefficients((order + 1u) * (order + 1u), R(0));
+            std::vector<R> ring(ringSamples), re, im;
+            for (size_t j = 0; j < rings; j++) {
+                for (size_t k = 0; k < ringSamples; k++) {
+                    ring[k] = R(polarFunction(dPhi * k, tettas[j]));
+                }
+                fft::realTransform(ring.data(), ringSamples, re, im);
+
+                const real *p = &legendre[j * stride];
+                const real w = weights[j] * dPhi;
+                for (int m = 0; m <= order; m++) {
+                    // sum f * cos(m * phi) = Re X(m), sum f * sin(m * phi) = -Im X(m)
+                    const R c = m == 0 ? re[0] * w : re[m] * (w * math::SQRT2);
+                    const R s = im[m] * (-w * math::SQRT2);
+                    for (int l = m; l <= order; l++) {
+                        const real plm = p[math::legendreIndex(l, m)];
+                        coefficients[l * (l + 1) + m] += c * plm;
+                        if (m > 0) {
+                            coefficients[l * (l + 1) - m] += s * plm;
+                        }
+                    }
+                }
+            }
+            return coefficients;
+        }
+    };
+}
+
+#endif //SH_SPHERICALTRANSFORM_H
@@ -0,0 +1,145 @@
+#ifndef SH_TEXELBASIS_H
+#define SH_TEXELBASIS_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Basis functions at texel centers of canonical texels, orbits are numbered in the order of symmetry::orbits().
+     * Tables depend on (size, order) only and are built once, see get(), so decoding many signals at the same
+     * resolution evaluates the basis once. The cache is bounded, tables of sizes no longer decoded are dropped
+     */
+    class TexelBasis {
+    protected:
+        uint16_t size;
+        uint16_t order;
+        size_t stride;
+        std::vector<real> table;
+    public:
+        TexelBasis(uint16_t size, uint16_t order) : size(size), order(order), stride((order + 1u) * (order + 1u)) {
+            table.reserve(6u * size * size * stride / symmetry::ELEMENTS + 2u * size * stride);
+            symmetry::orbits(size, [this](const symmetry::Orbit &orbit) {
+                table.resize(table.size() + stride);
+                math::basis(this->order, orbit.direction, &table[table.size() - stride]);
+            });
+        }
+
+        uint16_t getSize() const {
+            return size;
+        }
+
+        uint16_t getOrder() const {
+            return order;
+        }
+
+        /**
+         * Basis functions at the center of canonical texel of orbit, index l * (l + 1) + m
+         * @param orbit
+         * @return
+         */
+        const real *operator()(size_t orbit) const {
+            return &table[orbit * stride];
+        }
+
+        static const size_t MAX_VALUES = 1u << 24u;
+
+        /**
+         * Values all cached tables may hold together, least recently requested tables are dropped beyond it
+         */
+        static const size_t CACHE_VALUES = MAX_VALUES;
+
+        static bool affordable(uint16_t size, uint16_t order) {
+            return (size_t) 6u * size * size * (order + 1u) * (order + 1u) / symmetry::ELEMENTS <= MAX_VALUES;
+        }
+
+        /**
+         * Shared tables for (size, order), built on first request and kept while the cache has room, see
+         * CACHE_VALUES
+         * @param size
+         * @param order
+         * @return
+         */
+        static std::shared_ptr<const TexelBasis> get(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            const auto key = std::make_pair(size, order);
+            auto found = cache.tables.find(key);
+            if (found != cache.tables.end()) {
+                found->second.used = ++cache.clock;
+                return found->second.basis;
+            }
+
+            auto basis = std::make_shared<const TexelBasis>(size, order);
+            while (!cache.tables.empty() && cache.values + basis->table.size() > CACHE_VALUES) {
+                auto oldest = cache.tables.begin();
+                for (auto entry = cache.tables.begin(); entry != cache.tables.end(); entry++) {
+                    if (entry->second.used < oldest->second.used) {
+                        oldest = entry;
+                    }
+                }
+                cache.values -= oldest->second.basis->table.size();
+                cache.tables.erase(oldest);
+            }
+            cache.tables[key] = {basis, ++cache.clock};
+            cache.values += basis->table.size();
+            return basis;
+        }
+
+        /**
+         * Whether tables for (size, order) are built and kept by the cache
+         * @param size
+         * @param order
+         * @return
+         */
+        static bool cached(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            return cache.tables.count(std::make_pair(size, order)) > 0;
+        }
+
+        /**
+         * Drop tables for (size, order) from the cache, holders of the tables keep them alive
+         * @param size
+         * @param order
+         */
+        static void release(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto found = cache.tables.find(std::make_pair(size, order));
+            if (found != cache.tables.end()) {
+                cache.values -= found->second.basis->table.size();
+                cache.tables.erase(found);
+            }
+        }
+
+    protected:
+        struct Entry {
+            std::shared_ptr<const TexelBasis> basis;
+            uint64_t used;
+        };
+
+        struct Cache {
+            std::mutex mutex;
+            std::map<std::pair<uint16_t, uint16_t>, Entry> tables;
+            size_t values = 0;
+            uint64_t clock = 0;
+        };
+
+        static Cache &getCache() {
+            static Cache cache;
+            return cache;
+        }
+    };
+}
+
+#endif //SH_TEXELBASIS_H
@@ -0,0 +1,219 @@
+#ifndef SH_TEXELINTEGRALS_H
+#define SH_TEXELINTEGRALS_H
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    /**
+     * Integrals of every basis function Y(l, m) over every texel of a cubemap face, instead of basis value at texel
+     * center multiplied by texel solid angle. Texel is integrated in its (s, t) face coordinates with Jacobian
+     * (1 + s^2 + t^2)^(-3/2) by Gauss-Legendre product rule, which is refined until it stops changing.
+     * Only canonical texels of symmetry orbits are kept. Tables depend on (size, order) only and are built once,
+     * see get(), the cache of tables is bounded and tables may be released
+     */
+    class TexelIntegrals {
+    protected:
+        uint16_t size;
+        uint16_t order;
+        size_t stride;
+        std::vector<real> table;
+
+        /**
+         * Integrate all basis functions over texel with q x q Gauss-Legendre rule
+         */
+        void integrate(const mat3 &transform, real s0, real t0, real d, const std::vector<real> &nodes,
+                const std::vector<real> &weights, real *out, real *y) const {
+            std::fill(out, out + stride, 0);
+            const real half = d * 0.5;
+            for (size_t a = 0; a < nodes.size(); a++) {
+                const real t = t0 + half * (nodes[a] + 1);
+                for (size_t b = 0; b < nodes.size(); b++) {
+                    const real s = s0 + half * (nodes[b] + 1);
+                    const real r2 = 1 + s * s + t * t;
+                    const real w = weights[a] * weights[b] * half * half / (r2 * std::sqrt(r2));
+                    math::basis(order, transform * glm::normalize(vec3(s, t, -1)), y);
+                    for (size_t k = 0; k < stride; k++) {
+                        out[k] += y[k] * w;
+                    }
+                }
+            }
+        }
+
+    public:
+        /**
+         * @param size face width and height in texels
+         * @param order max band index
+         * @param tolerance allowed absolute error of integral relative to texel solid angle
+         */
+        TexelIntegrals(uint16_t size, uint16_t order, real tolerance = 1e-10) :
+                size(size), order(order), stride((order + 1u) * (order + 1u)) {
+            table.reserve(6u * size * size * stride / symmetry::ELEMENTS + 2u * size * stride);
+            std::map<int, std::pair<std::vector<real>, std::vector<real>>> rules;
+            auto rule = [&rules](int q) -> const std::pair<std::vector<real>, std::vector<real>> & {
+                auto found = rules.find(q);
+                if (found == rules.end()) {
+                    found = rules.emplace(q, std::pair<std::vector<real>, std::vector<real>>()).first;
+                    math::gaussLegendre(q, found->second.first, found->second.second);
+                }
+                return found->second;
+            };
+
+            const real d = 2.0 / size;
+            std::vector<real> y(stride), coarse(stride);
+            symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+                const mat3 &transform = faceTransforms().at(orbit.texel.face);
+                const real s0 = -1 + d * orbit.texel.j, t0 = -1 + d * orbit.texel.i;
+                const real limit = tolerance * solidAngle(std::abs(s0 + d * 0.5), std::abs(t0 + d * 0.5), d, d);
+                table.resize(table.size() + stride);
+                real *out = &table[table.size() - stride];
+
+                int q = 2;
+                integrate(transform, s0, t0, d, rule(q).first, rule(q).second, coarse.data(), y.data());
+                for (; q < 64; q *= 2) {
+                    integrate(transform, s0, t0, d, rule(2 * q).first, rule(2 * q).second, out, y.data());
+                    real change = 0;
+                    for (size_t k = 0; k < stride; k++) {
+                        change = std::max(change, std::abs(out[k] - coarse[k]));
+                    }
+                    if (change <= limit) {
+                        break;
+                    }
+                    std::copy(out, out + stride, coarse.begin());
+                }
+            });
+        }
+
+        uint16_t getSize() const {
+            return size;
+        }
+
+        uint16_t getOrder() const {
+            return order;
+        }
+
+        /**
+         * Integrals of all (order + 1)^2 basis functions over canonical texel of orbit, orbits are numbered in the
+         * order of symmetry::orbits(). Integrals over other texels of the orbit are the same up to BasisAction
+         * @param orbit
+         * @return
+         */
+        const real *operator()(size_t orbit) const {
+            return &table[orbit * stride];
+        }
+
+        /**
+         * Tables grow as 6 * size^2 * (order + 1)^2 / 16, large faces resolve the basis well with texel centers
+         * anyway, so tables are only worth keeping up to this amount of values
+         */
+        static const size_t MAX_VALUES = 1u << 24u;
+
+        static bool affordable(uint16_t size, uint16_t order) {
+            return (size_t) 6u * size * size * (order + 1u) * (order + 1u) / symmetry::ELEMENTS <= MAX_VALUES;
+        }
+
+        /**
+         * Values all cached tables may hold together, least recently requested tables are dropped beyond it
+         */
+        static const size_t CACHE_VALUES = MAX_VALUES;
+
+        /**
+         * Shared tables for (size, order), built on first request and kept while the cache has room, see
+         * CACHE_VALUES
+         * @param size
+         * @param order
+         * @return
+         */
+        static std::shared_ptr<const TexelIntegrals> get(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            const auto key = std::make_pair(size, order);
+            auto found = cache.tables.find(key);
+            if (found != cache.tables.end()) {
+                found->second.used = ++cache.clock;
+                return found->second.integrals;
+            }
+
+            auto integrals = std::make_shared<const TexelIntegrals>(size, order);
+            while (!cache.tables.empty() && cache.values + integrals->table.size() > CACHE_VALUES) {
+                auto oldest = cache.tables.begin();
+                for (auto entry = cache.tables.begin(); entry != cache.tables.end(); entry++) {
+                    if (entry->second.used < oldest->second.used) {
+                        oldest = entry;
+                    }
+                }
+                cache.values -= oldest->second.integrals->table.size();
+                cache.tables.erase(oldest);
+            }
+            cache.tables[key] = {integrals, ++cache.clock};
+            cache.values += integrals->table.size();
+            return integrals;
+        }
+
+        /**
+         * Tables for size already built by get() for given or higher order, nothing is built. Basis index doesn't
+         * depend on order, so higher order tables hold all requested integrals
+         * @param size
+         * @param order
+         * @return null when no such tables are cached
+         */
+        static std::shared_ptr<const TexelIntegrals> find(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto found = cache.tables.lower_bound(std::make_pair(size, order));
+            if (found == cache.tables.end() || found->first.first != size) {
+                return nullptr;
+            }
+            found->second.used = ++cache.clock;
+            return found->second.integrals;
+        }
+
+        /**
+         * Drop tables for (size, order) from the cache, holders of the tables keep them alive
+         * @param size
+         * @param order
+         */
+        static void release(uint16_t size, uint16_t order) {
+            Cache &cache = getCache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            auto found = cache.tables.find(std::make_pair(size, order));
+            if (found != cache.tables.end()) {
+                cache.values -= found->second.integrals->table.size();
+                cache.tables.erase(found);
+            }
+        }
+
+    protected:
+        struct Entry {
+            std::shared_ptr<const TexelIntegrals> integrals;
+            uint64_t used;
+        };
+
+        struct Cache {
+            std::mutex mutex;
+            std::map<std::pair<uint16_t, uint16_t>, Entry> tables;
+            size_t values = 0;
+            uint64_t clock = 0;
+        };
+
+        static Cache &getCache() {
+            static Cache cache;
+            return cache;
+        }
+    };
+}
+
+#endif //SH_TEXELINTEGRALS_H
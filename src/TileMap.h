@@ -0,0 +1,231 @@
+#ifndef SH_TILEMAP_H
+#define SH_TILEMAP_H
+
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+
+#include "real.h"
+#include "CubeMap.h"
+#include "ShCoefficients.h"
+#include "TexelIntegrals.h"
+#include "CubeMapSymmetry.h"
+
+namespace sh {
+
+    enum class TileKind : uint8_t {
+        Zero,
+        Constant,
+        Mixed
+    };
+
+    /**
+     * Coarse map of cubemap faces split into square tiles of texels, every tile is marked as all zero, constant or
+     * mixed. Texels are compared bitwise. Tiles at the far edges are smaller if tile size doesn't divide face size
+     */
+    template<class F>
+    class TileMap {
+    protected:
+        int size;
+        int tile;
+        int tiles;
+        std::vector<TileKind> kinds;
+        std::vector<F> values;
+
+    public:
+        /**
+         * @param cubemap
+         * @param tile tile width and height in texels
+         */
+        TileMap(CubeMap<F> &cubemap, int tile = 8) : size(cubemap.getWidth()), tile(std::max(1, tile)) {
+            if (!cubemap.isSquare()) {
+                throw std::runtime_error("TileMap: cubemap faces have to be square and of the same size");
+            }
+            tiles = (size + this->tile - 1) / this->tile;
+            kinds.resize(6u * tiles * tiles);
+            values.resize(6u * tiles * tiles);
+
+            F zero;
+            std::memset(&zero, 0, sizeof(F));
+            for (auto &item : faceTransforms()) {
+                const F *data = cubemap[item.first]->getData();
+                for (int ti = 0; ti < tiles; ti++) {
+                    for (int tj = 0; tj < tiles; tj++) {
+                        const F &first = data[ti * this->tile * size + tj * this->tile];
+                        bool constant = true;
+                        for (int i = ti * this->tile; i < std::min(size, (ti + 1) * this->tile) && constant; i++) {
+                            for (int j = tj * this->tile; j < std::min(size, (tj + 1) * this->tile) && constant; j++) {
+                                constant = std::memcmp(&data[i * size + j], &first, sizeof(F)) == 0;
+                            }
+                        }
+                        const size_t at = index(item.first, ti, tj);
+                        values[at] = first;
+                        kinds[at] = !constant ? TileKind::Mixed :
+                                    std::memcmp(&first, &zero, sizeof(F)) == 0 ? TileKind::Zero : TileKind::Constant;
+                    }
+                }
+            }
+        }
+
+        int getSize() const {
+            return size;
+        }
+
+        int getTile() const {
+            return tile;
+        }
+
+        /**
+         * Tiles per face side
+         * @return
+         */
+        int getTiles() const {
+            return tiles;
+        }
+
+        size_t index(CubeMapFaceEnum face, int ti, int tj) const {
+            return ((size_t) face * tiles + ti) * tiles + tj;
+        }
+
+        TileKind kind(CubeMapFaceEnum face, int ti, int tj) const {
+            return kinds[index(face, ti, tj)];
+        }
+
+        /**
+         * Value of texels of constant tile
+         */
+        const F &value(CubeMapFaceEnum face, int ti, int tj) const {
+            return values[index(face, ti, tj)];
+        }
+
+        size_t count(TileKind kind) const {
+            return (size_t) std::count(kinds.begin(), kinds.end(), kind);
+        }
+    };
+
+    /**
+     * Integral of basis functions over a tile, sum of texel integrals, index l * (l + 1) + m
+     * @param integrals texel integrals for the face size
+     * @param texelOrbits
+     * @param action
+     * @param face
+     * @param ti
+     * @param tj
+     * @param tile tile width and height in texels
+     * @param out (order + 1)^2 values
+     */
+    void tileIntegral(const TexelIntegrals &integrals, const symmetry::TexelOrbits &texelOrbits,
+            const symmetry::BasisAction &action, CubeMapFaceEnum face, int ti, int tj, int tile, real *out) {
+        const size_t n = (integrals.getOrder() + 1u) * (integrals.getOrder() + 1u);
+        const int size = texelOrbits.getSize();
+        std::fill(out, out + n, real(0));
+        for (int i = ti * tile; i < std::min(size, (ti + 1) * tile); i++) {
+            for (int j = tj * tile; j < std::min(size, (tj + 1) * tile); j++) {
+                const real *y = integrals(texelOrbits.orbit(face, i, j));
+                const uint8_t element = texelOrbits.element(face, i, j);
+                for (size_t k = 0; k < n; k++) {
+                    out[k] += y[action.index(element, k)] * action.sign(element, k);
+                }
+            }
+        }
+    }
+
+    /**
+     * Project cubemap skipping trivial tiles: zero tiles contribute nothing, constant tiles contribute their value
+     * times the integral over the tile, texels of mixed tiles are weighted by texel integrals as in projectCubeMap.
+     * If tile size divides face size, the symmetry group maps tiles onto tiles, so tile integrals are computed once
+     * per orbit of constant tiles. Face size has to be small enough for TexelIntegrals tables
+     * @param cubemap
+     * @param tiles tile map of the cubemap
+     * @param order
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> projectTiles(CubeMap<F> &cubemap, const TileMap<F> &tiles, uint16_t order) {
+        const size_t n = (order + 1u) * (order + 1u);
+        const int size = tiles.getSize(), tile = tiles.getTile();
+        if (!cubemap.isSquare() || cubemap.getWidth() != size) {
+            throw std::runtime_error("projectTiles: tile map doesn't match the cubemap");
+        }
+        const auto integrals = TexelIntegrals::get((uint16_t) size, order);
+        const auto texelOrbits = symmetry::TexelOrbits::get(size);
+        const symmetry::BasisAction action(order);
+
+        // tiles of a tile-aligned cubemap are texels of a cubemap with face size tiles.getTiles()
+        const bool symmetric = size % tile == 0;
+        std::shared_ptr<const symmetry::TexelOrbits> tileOrbits;
+        std::vector<symmetry::Texel> canonical;
+        std::vector<std::vector<real>> tileIntegrals;
+        if (symmetric && tiles.count(TileKind::Constant) > 0) {
+            tileOrbits = symmetry::TexelOrbits::get(tiles.getTiles());
+            canonical.resize(6u * tiles.getTiles() * tiles.getTiles());
+            tileIntegrals.resize(canonical.size());
+            for (auto &item : faceTransforms()) {
+                for (int ti = 0; ti < tiles.getTiles(); ti++) {
+                    for (int tj = 0; tj < tiles.getTiles(); tj++) {
+                        if (tileOrbits->element(item.first, ti, tj) == 0) {
+                            canonical[tileOrbits->orbit(item.first, ti, tj)] = {item.first, ti, tj};
+                        }
+                    }
+                }
+            }
+        }
+
+        ShCoefficients<R> coefficients(n, R(0));
+        std::vector<ShCoefficients<R>> sums(symmetry::ELEMENTS, ShCoefficients<R>(n, R(0)));
+        std::vector<real> y(n);
+        for (auto &item : faceTransforms()) {
+            const F *data = cubemap[item.first]->getData();
+            for (int ti = 0; ti < tiles.getTiles(); ti++) {
+                for (int tj = 0; tj < tiles.getTiles(); tj++) {
+                    const TileKind kind = tiles.kind(item.first, ti, tj);
+                    if (kind == TileKind::Constant && symmetric) {
+                        // integral over canonical tile of the orbit, mapped by the group like texel integrals
+                        const uint32_t orbit = tileOrbits->orbit(item.first, ti, tj);
+                        std::vector<real> &integral = tileIntegrals[orbit];
+                        if (integral.empty()) {
+                            const symmetry::Texel &texel = canonical[orbit];
+                            integral.resize(n);
+                            tileIntegral(*integrals, *texelOrbits, action, texel.face, texel.i, texel.j, tile,
+                                    integral.data());
+                        }
+                        const R value = R(tiles.value(item.first, ti, tj));
+                        ShCoefficients<R> &sum = sums[tileOrbits->element(item.first, ti, tj)];
+                        for (size_t k = 0; k < n; k++) {
+                            sum[k] += value * integral[k];
+                        }
+                    } else if (kind == TileKind::Constant) {
+                        const R value = R(tiles.value(item.first, ti, tj));
+                        tileIntegral(*integrals, *texelOrbits, action, item.first, ti, tj, tile, y.data());
+                        for (size_t k = 0; k < n; k++) {
+                            coefficients[k] += value * y[k];
+                        }
+                    } else if (kind == TileKind::Mixed) {
+                        for (int i = ti * tile; i < std::min(size, (ti + 1) * tile); i++) {
+                            for (int j = tj * tile; j < std::min(size, (tj + 1) * tile); j++) {
+                                const R sample = R(data[i * size + j]);
+                                const real *texelY = (*integrals)(texelOrbits->orbit(item.first, i, j));
+                                ShCoefficients<R> &sum = sums[texelOrbits->element(item.first, i, j)];
+                                for (size_t k = 0; k < n; k++) {
+                                    sum[k] += sample * texelY[k];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t k = 0; k < n; k++) {
+                coefficients[k] += sums[element][action.index(element, k)] * action.sign(element, k);
+            }
+        }
+        return coefficients;
+    }
+}
+
+#endif //SH_TILEMAP_H
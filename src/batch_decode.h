@@ -0,0 +1,180 @@
+#ifndef SH_BATCH_DECODE_H
+#define SH_BATCH_DECODE_H
+
+#include <cmath>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "ShCoefficients.h"
+#include "parallel.h"
+#include "QuadraticForm.h"
+#include "FixedOrder.h"
+
+namespace sh {
+
+    /**
+     * Amount of directions decoded in lock step. Recurrence coefficients are shared by all lanes and loops over lanes
+     * have no dependencies, so compiler turns them into SIMD code
+     */
+    const size_t DECODE_LANES = 16;
+
+    /**
+     * Decode up to DECODE_LANES directions given by coordinates
+     * @param coefficients
+     * @param x
+     * @param y
+     * @param z
+     * @param count
+     * @param out
+     */
+    template<class R>
+    void decodeLanes(const ShCoefficients<R> &coefficients, const real *x, const real *y, const real *z, size_t count,
+            R *out) {
+        const int n = order(coefficients);
+        real somx2[DECODE_LANES], cosPhi[DECODE_LANES], sinPhi[DECODE_LANES];
+        real pmm[DECODE_LANES], cm[DECODE_LANES], sm[DECODE_LANES];
+        real p1[DECODE_LANES], p2[DECODE_LANES];
+        R cosSum[DECODE_LANES], sinSum[DECODE_LANES];
+
+        for (size_t k = 0; k < count; k++) {
+            somx2[k] = std::sqrt(std::max<real>(0, (1 - y[k]) * (1 + y[k])));
+            cosPhi[k] = somx2[k] > 0 ? z[k] / somx2[k] : 1;
+            sinPhi[k] = somx2[k] > 0 ? x[k] / somx2[k] : 0;
+            pmm[k] = std::sqrt(1 / math::PI4);
+            cm[k] = 1;
+            sm[k] = 0;
+            out[k] = R(0);
+        }
+
+        for (int m = 0; m <= n; m++) {
+            if (m > 0) {
+                const real factor = -std::sqrt((2 * m + 1) / (2.0 * m));
+                for (size_t k = 0; k < count; k++) {
+                    pmm[k] *= factor * somx2[k];
+                    const real c = cm[k] * cosPhi[k] - sm[k] * sinPhi[k];
+                    sm[k] = sm[k] * cosPhi[k] + cm[k] * sinPhi[k];
+                    cm[k] = c;
+                }
+            }
+
+            const R &cmm = coefficients[m * (m + 1) + m], &smm = coefficients[m * (m + 1) - m];
+            for (size_t k = 0; k < count; k++) {
+                p1[k] = pmm[k];
+                p2[k] = 0;
+                cosSum[k] = cmm * pmm[k];
+                sinSum[k] = smm * pmm[k];
+            }
+
+            for (int l = m + 1; l <= n; l++) {
+                real a = std::sqrt(2.0 * m + 3), b = 0;
+                if (l > m + 1) {
+                    math::recurrence(l, m, a, b);
+                }
+                const R &c = coefficients[l * (l + 1) + m], &s = coefficients[l * (l + 1) - m];
+                for (size_t k = 0; k < count; k++) {
+                    const real p = a * (y[k] * p1[k] - b * p2[k]);
+                    p2[k] = p1[k];
+                    p1[k] = p;
+                    cosSum[k] += c * p;
+                    sinSum[k] += s * p;
+                }
+            }
+
+            if (m == 0) {
+                for (size_t k = 0; k < count; k++) {
+                    out[k] += cosSum[k];
+                }
+            } else {
+                for (size_t k = 0; k < count; k++) {
+                    out[k] += cosSum[k] * (math::SQRT2 * cm[k]) + sinSum[k] * (math::SQRT2 * sm[k]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Decode signal at many unit directions given as structure of arrays. Directions are processed by groups of
+     * DECODE_LANES, groups are spread over threads of the shared ThreadPool: nothing is allocated and no thread is
+     * started per call.
+     * Signals up to order 2 are evaluated as QuadraticForm, up to FIXED_ORDER by closed form basis
+     * @param coefficients
+     * @param x
+     * @param y
+     * @param z
+     * @param count
+     * @param out count values
+     * @param threads amount of chunks, 0 - threads of the shared pool
+     */
+    template<class R>
+    void decode(const ShCoefficients<R> &coefficients, const real *x, const real *y, const real *z, size_t count,
+            R *out, unsigned threads = 0) {
+        if (coefficients.size() <= 9) {
+            const QuadraticForm<R> form(coefficients);
+            parallelFor(count, threads, 65536, [&](size_t begin, size_t end) {
+                form(x + begin, y + begin, z + begin, end - begin, out + begin);
+            });
+            return;
+        }
+        if (order(coefficients) <= FIXED_ORDER) {
+            dispatch(order(coefficients), [&](auto fixed) {
+                parallelFor(count, threads, 16384, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        out[i] = decode<decltype(fixed)::value>(coefficients.data(), vec3(x[i], y[i], z[i]));
+                    }
+                });
+            });
+            return;
+        }
+        parallelFor(count, threads, 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i += DECODE_LANES) {
+                decodeLanes(coefficients, x + i, y + i, z + i, std::min(DECODE_LANES, end - i), out + i);
+            }
+        });
+    }
+
+    /**
+     * Decode signal at many unit directions given as array of structures, see decode() taking structure of arrays
+     * @param coefficients
+     * @param directions
+     * @param count
+     * @param out count values
+     * @param threads amount of chunks, 0 - threads of the shared pool
+     */
+    template<class R>
+    void decode(const ShCoefficients<R> &coefficients, const vec3 *directions, size_t count, R *out,
+            unsigned threads = 0) {
+        if (coefficients.size() <= 9) {
+            const QuadraticForm<R> form(coefficients);
+            parallelFor(count, threads, 65536, [&](size_t begin, size_t end) {
+                form(directions + begin, end - begin, out + begin);
+            });
+            return;
+        }
+        if (order(coefficients) <= FIXED_ORDER) {
+            dispatch(order(coefficients), [&](auto fixed) {
+                parallelFor(count, threads, 16384, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        out[i] = decode<decltype(fixed)::value>(coefficients.data(), directions[i]);
+                    }
+                });
+            });
+            return;
+        }
+        parallelFor(count, threads, 4096, [&](size_t begin, size_t end) {
+            real x[DECODE_LANES], y[DECODE_LANES], z[DECODE_LANES];
+            for (size_t i = begin; i < end; i += DECODE_LANES) {
+                const size_t lanes = std::min(DECODE_LANES, end - i);
+                for (size_t k = 0; k < lanes; k++) {
+                    x[k] = directions[i + k].x;
+                    y[k] = directions[i + k].y;
+                    z[k] = directions[i + k].z;
+                }
+                decodeLanes(coefficients, x, y, z, lanes, out + i);
+            }
+        });
+    }
+}
+
+#endif //SH_BATCH_DECODE_H
@@ -0,0 +1,207 @@
+#ifndef SH_CONVOLUTION_H
+#define SH_CONVOLUTION_H
+
+#include <vector>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+#include "ShCoefficients.h"
+
+namespace sh {
+
+    /**
+     * Zonal kernels as per band factors. Convolution of signal with kernel h(cos(angle)) symmetric around the axis
+     * multiplies every coefficient of band l by 2 * PI * integral(h(t) * P(l, 0, t), -1, 1) (Funk-Hecke theorem)
+     */
+    namespace kernel {
+
+        /**
+         * Factors of kernel given by its zonal coefficients z(l): h(t) = sum z(l) * y(l, 0, t)
+         * @param zonal
+         * @return
+         */
+        std::vector<real> zonal(const std::vector<real> &zonal) {
+            std::vector<real> factors(zonal.size());
+            for (size_t l = 0; l < zonal.size(); l++) {
+                factors[l] = std::sqrt(math::PI4 / (2 * l + 1)) * zonal[l];
+            }
+            return factors;
+        }
+
+        /**
+         * Factors of kernel given by its profile, integrated numerically. Lobes peak at t = 1, so quadrature
+         * panels get geometrically finer towards it and narrow lobes are resolved as well as wide ones
+         * @param order
+         * @param profile h(t), t is cosine of angle from the axis
+         * @param lower profile is zero below, 0 for lobes clamped to hemisphere
+         * @return
+         */
+        std::vector<real> profile(uint16_t order, const std::function<real(real)> &profile, real lower = -1) {
+            std::vector<real> nodes, weights;
+            math::gaussLegendre(std::max(8, order / 2 + 8), nodes, weights);
+
+            std::vector<real> factors(order + 1u, 0);
+            real a = lower;
+            for (int panel = 1; panel <= 48; panel++) {
+                const real b = panel == 48 ? 1 : 1 - (1 - lower) * std::pow(0.5, panel);
+                for (size_t k = 0; k < nodes.size(); k++) {
+                    const real t = 0.5 * (a + b) + 0.5 * (b - a) * nodes[k];
+                    const real w = 0.5 * (b - a) * weights[k] * profile(t) * math::PI2;
+                    // Legendre polynomials P(l, 0, t) by recurrence
+                    real p0 = 1, p1 = t;
+                    factors[0] += w;
+                    for (int l = 1; l <= order; l++) {
+                        factors[l] += w * p1;
+                        const real p2 = ((2 * l + 1) * t * p1 - l * p0) / (l + 1);
+                        p0 = p1;
+                        p1 = p2;
+                    }
+                }
+                a = b;
+            }
+            return factors;
+        }
+
+        /**
+         * Factors of kernel given by profile table, samples are spaced uniformly in angle from 0 to PI and
+         * interpolated linearly. Single sample is a constant profile, which only has band 0
+         * @param order
+         * @param samples
+         * @return
+         */
+        std::vector<real> tabulated(uint16_t order, const std::vector<real> &samples) {
+            if (samples.size() < 2) {
+                std::vector<real> factors(order + 1u, 0);
+                factors[0] = samples.empty() ? 0 : samples[0] * math::PI4;
+                return factors;
+            }
+            return profile(order, [&samples](real t) {
+                const real x = std::acos(std::max<real>(-1, std::min<real>(1, t))) / math::PI * (samples.size() - 1);
+                const size_t i = std::min(samples.size() - 2, (size_t) x);
+                const real f = x - i;
+                return samples[i] * (1 - f) + samples[i + 1] * f;
+            });
+        }
+
+        /**
+         * Scale factors so that constant signal is preserved
+         * @param factors
+         * @return
+         */
+        std::vector<real> normalized(std::vector<real> factors) {
+            const real norm = factors.empty() || factors[0] == 0 ? 1 : factors[0];
+            for (auto &factor : factors) {
+                factor /= norm;
+            }
+            return factors;
+        }
+
+        /**
+         * Clamped cosine max(t, 0): convolution of radiance gives irradiance. Closed form
+         * @param order
+         * @return
+         */
+        std::vector<real> cosine(uint16_t order) {
+            std::vector<real> factors(order + 1u, 0);
+            for (int l = 0; l <= order; l++) {
+                if (l == 1) {
+                    factors[l] = math::PI2 / 3;
+                } else if (l % 2 == 0) {
+                    // 2 * PI * (-1)^(l / 2 - 1) / ((l + 2) * (l - 1)) * l! / (2^l * ((l / 2)!)^2)
+                    real binomial = 1;
+                    for (int k = 1; k <= l / 2; k++) {
+                        binomial *= (l / 2.0 + k) / k / 4;
+                    }
+                    factors[l] = math::PI2 * ((l / 2) % 2 ? 1 : -1) / ((l + 2) * (l - 1)) * binomial;
+                }
+            }
+            return factors;
+        }
+
+        /**
+         * Normalized Phong lobe (n + 1) / (2 * PI) * max(t, 0)^n
+         * @param order
+         * @param exponent
+         * @return
+         */
+        std::vector<real> phong(uint16_t order, real exponent) {
+            return profile(order, [exponent](real t) {
+                return (exponent + 1) / math::PI2 * std::pow(std::max<real>(0, t), exponent);
+            }, 0);
+        }
+
+        /**
+         * Normalized spherical Gaussian exp((t - 1) / width^2)
+         * @param order
+         * @param width angular width, radians
+         * @return
+         */
+        std::vector<real> gaussian(uint16_t order, real width) {
+            const real sharpness = 1 / std::max<real>(width * width, 1e-12);
+            return normalized(profile(order, [sharpness](real t) {
+                return std::exp((t - 1) * sharpness);
+            }));
+        }
+
+        /**
+         * Normalized GGX distribution of normals around the axis, alpha = roughness^2
+         * @param order
+         * @param roughness
+         * @return
+         */
+        std::vector<real> ggx(uint16_t order, real roughness) {
+            if (roughness <= 0) {
+                return std::vector<real>(order + 1u, 1);
+            }
+            const real a2 = std::max<real>(roughness * roughness * roughness * roughness, 1e-12);
+            return normalized(profile(order, [a2](real t) {
+                const real d = (a2 - 1) * t * t + 1;
+                return a2 / (math::PI * d * d);
+            }, 0));
+        }
+
+        /**
+         * GGX specular lobe around the reflected direction as used by split sum prefiltering (normal, view and
+         * reflected directions coincide): light directions are weighted by D(half vector) * cosine, the half vector
+         * is at half the angle from the axis
+         * @param order
+         * @param roughness
+         * @return
+         */
+        std::vector<real> specular(uint16_t order, real roughness) {
+            if (roughness <= 0) {
+                return std::vector<real>(order + 1u, 1);
+            }
+            const real a2 = roughness * roughness * roughness * roughness;
+            return normalized(profile(order, [a2](real t) {
+                const real h2 = (1 + t) * 0.5;
+                const real d = (a2 - 1) * h2 + 1;
+                return a2 / (math::PI * d * d) * t;
+            }, 0));
+        }
+    }
+
+    /**
+     * Convolve signal with zonal kernel in coefficient space
+     * @param coefficients
+     * @param factors per band factors of the kernel, see kernel namespace. Bands beyond factors are zeroed
+     * @return
+     */
+    template<class R>
+    ShCoefficients<R> convolve(const ShCoefficients<R> &coefficients, const std::vector<real> &factors) {
+        const auto n = order(coefficients);
+        ShCoefficients<R> result(coefficients.size(), R(0));
+        for (int l = 0; l <= n && l < (int) factors.size(); l++) {
+            for (int m = -l; m <= l; m++) {
+                result[l * (l + 1) + m] = coefficients[l * (l + 1) + m] * factors[l];
+            }
+        }
+        return result;
+    }
+}
+
+#endif //SH_CONVOLUTION_H
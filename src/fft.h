@@ -0,0 +1,109 @@
+#ifndef SH_FFT_H
+#define SH_FFT_H
+
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "real.h"
+#include "shmath.h"
+
+namespace sh {
+    namespace fft {
+
+        inline bool isPowerOfTwo(size_t n) {
+            return n > 0 && (n & (n - 1)) == 0;
+        }
+
+        inline size_t nextPowerOfTwo(size_t n) {
+            size_t p = 1;
+            while (p < n) {
+                p <<= 1u;
+            }
+            return p;
+        }
+
+        /**
+         * In-place radix-2 complex FFT: X(m) = sum x(k) * exp(-2 * pi * i * m * k / n).
+         * Real and imaginary parts are kept in separate arrays, T may be any value supporting +, - and scalar *
+         * (real, RGB, RGBA...)
+         * @param re real parts, n items
+         * @param im imaginary parts, n items
+         * @param n transform size, power of two
+         */
+        template<class T>
+        void complexTransform(T *re, T *im, size_t n) {
+            if (!isPowerOfTwo(n)) {
+                throw std::runtime_error("fft: transform size must be power of two " + std::to_string(n));
+            }
+
+            for (size_t i = 1, j = 0; i < n; i++) {
+                size_t bit = n >> 1u;
+                for (; j & bit; bit >>= 1u) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(re[i], re[j]);
+                    std::swap(im[i], im[j]);
+                }
+            }
+
+            for (size_t length = 2; length <= n; length <<= 1u) {
+                const real angle = -math::PI2 / length;
+                const real wr = std::cos(angle), wi = std::sin(angle);
+                for (size_t i = 0; i < n; i += length) {
+                    real cr = 1, ci = 0;
+                    for (size_t j = 0; j < length / 2; j++) {
+                        const size_t a = i + j, b = a + length / 2;
+                        const T tr = re[b] * cr - im[b] * ci;
+                        const T ti = re[b] * ci + im[b] * cr;
+                        re[b] = re[a] - tr;
+                        im[b] = im[a] - ti;
+                        re[a] += tr;
+                        im[a] += ti;
+
+                        const real next = cr * wr - ci * wi;
+                        ci = cr * wi + ci * wr;
+                        cr = next;
+                    }
+                }
+            }
+        }
+
+        /**
+         * FFT of real valued sequence. Packs even and odd samples into a half sized complex transform and splits result,
+         * so only n / 2 + 1 non redundant harmonics are returned
+         * @param input n real samples
+         * @param n transform size, power of two (>= 2)
+         * @param re real parts of harmonics [0, n / 2]
+         * @param im imaginary parts of harmonics [0, n / 2]
+         */
+        template<class T>
+        void realTransform(const T *input, size_t n, std::vector<T> &re, std::vector<T> &im) {
+            const size_t half = n / 2;
+            std::vector<T> zr(half), zi(half);
+            for (size_t k = 0; k < half; k++) {
+                zr[k] = input[2 * k];
+                zi[k] = input[2 * k + 1];
+            }
+            complexTransform(zr.data(), zi.data(), half);
+
+            re.resize(half + 1);
+            im.resize(half + 1);
+            for (size_t m = 0; m <= half; m++) {
+                const size_t a = m % half, b = (half - m) % half;
+                const T er = (zr[a] + zr[b]) * 0.5;
+                const T ei = (zi[a] - zi[b]) * 0.5;
+                const T odr = (zi[a] + zi[b]) * 0.5;
+                const T odi = (zr[b] - zr[a]) * 0.5;
+                const real c = std::cos(math::PI2 * m / n), s = std::sin(math::PI2 * m / n);
+                re[m] = er + odr * c + odi * s;
+                im[m] = ei + odi * c - odr * s;
+            }
+        }
+    }
+}
+
+#endif //SH_FFT_H
@@ -0,0 +1,202 @@
+#ifndef SH_HOTSPOT_H
+#define SH_HOTSPOT_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "real.h"
+#include "shmath.h"
+#include "pixel_format.h"
+#include "CubeMap.h"
+#include "CubeMapDistribution.h"
+#include "ShCoefficients.h"
+#include "spherical_harmonic.h"
+
+namespace sh {
+
+    /**
+     * Small bright lobe of environment (sun) approximated by a spherical cap of constant radiance
+     */
+    template<class R>
+    struct Hotspot {
+        vec3 direction;
+        R radiance;
+        real angle;
+    };
+
+    /**
+     * Detect small high luminance lobes, cut them out of the cubemap and return them as spherical caps.
+     * Texels brighter than threshold * average luminance are greedily clustered around the brightest ones, every
+     * cluster is replaced with the average of its dim surrounding, the excess energy is kept in the hotspot
+     * @param cubemap modified in place: hotspot texels are masked out
+     * @param threshold luminance relative to the average luminance of the environment
+     * @param maxAngle max angular radius of single hotspot, radians
+     * @param maxHotspots
+     * @return
+     */
+    template<class R, class F>
+    std::vector<Hotspot<R>> extractHotspots(CubeMap<F> &cubemap, real threshold, real maxAngle = 0.175,
+            uint16_t maxHotspots = 4) {
+        struct BrightTexel {
+            F *texel;
+            vec3 direction;
+            real solidAngle;
+            real luminance;
+            int cluster;
+        };
+
+        const int w = cubemap.getWidth(), h = cubemap.getHeight();
+        const real ds = 2.0 / w, dt = 2.0 / h;
+        auto walk = [&](const std::function<void(F &, const vec3 &, real)> &visit) {
+            for (auto &item : faceTransforms()) {
+                F *data = cubemap[item.first]->getData();
+                for (int i = 0; i < h; i++) {
+                    const real t = -1 + dt * (i + 0.5);
+                    for (int j = 0; j < w; j++) {
+                        const real s = -1 + ds * (j + 0.5);
+                        const vec3 direction = item.second * glm::normalize(vec3(s, t, -1));
+                        visit(data[i * w + j], direction, solidAngle(std::abs(s), std::abs(t), ds, dt));
+                    }
+                }
+            }
+        };
+
+        real total = 0;
+        walk([&](F &texel, const vec3 &, real dw) {
+            total += std::max<real>(0, luminance(texel)) * dw;
+        });
+        const real limit = threshold * total / math::PI4;
+
+        std::vector<BrightTexel> bright;
+        walk([&](F &texel, const vec3 &direction, real dw) {
+            const real l = luminance(texel);
+            if (l > limit) {
+                bright.push_back({&texel, direction, dw, l, -1});
+            }
+        });
+        std::sort(bright.begin(), bright.end(), [](const BrightTexel &a, const BrightTexel &b) {
+            return a.luminance > b.luminance;
+        });
+
+        const real cosLimit = std::cos(maxAngle);
+        std::vector<vec3> seeds;
+        std::vector<real> radii;
+        for (auto &texel : bright) {
+            for (size_t c = 0; c < seeds.size() && texel.cluster < 0; c++) {
+                if (glm::dot(texel.direction, seeds[c]) > cosLimit) {
+                    texel.cluster = (int) c;
+                    radii[c] = std::max(radii[c], std::acos(std::min<real>(1, glm::dot(texel.direction, seeds[c]))));
+                }
+            }
+            if (texel.cluster < 0 && seeds.size() < maxHotspots) {
+                texel.cluster = (int) seeds.size();
+                seeds.push_back(texel.direction);
+                radii.push_back(0);
+            }
+        }
+
+        // surrounding ring is a couple of texels wider than the cluster
+        const real margin = 2 * std::max(ds, dt);
+        std::vector<R> fills(seeds.size(), R(0));
+        std::vector<real> fillWeights(seeds.size(), 0);
+        walk([&](F &texel, const vec3 &direction, real dw) {
+            if (luminance(texel) > limit) {
+                return;
+            }
+            for (size_t c = 0; c < seeds.size(); c++) {
+                if (glm::dot(direction, seeds[c]) > std::cos(radii[c] + margin)) {
+                    fills[c] += R(texel) * dw;
+                    fillWeights[c] += dw;
+                }
+            }
+        });
+        for (size_t c = 0; c < seeds.size(); c++) {
+            fills[c] = fillWeights[c] > 0 ? fills[c] * (1 / fillWeights[c]) : R(0);
+        }
+
+        std::vector<R> energies(seeds.size(), R(0));
+        std::vector<real> areas(seeds.size(), 0);
+        std::vector<vec3> centroids(seeds.size(), vec3(0));
+        for (auto &texel : bright) {
+            if (texel.cluster < 0) {
+                continue;
+            }
+            const R excess = R(*texel.texel) - fills[texel.cluster];
+            energies[texel.cluster] += excess * texel.solidAngle;
+            areas[texel.cluster] += texel.solidAngle;
+            centroids[texel.cluster] += texel.direction * (std::max<real>(0, luminance(excess)) * texel.solidAngle);
+            *texel.texel = F(fills[texel.cluster]);
+        }
+
+        std::vector<Hotspot<R>> hotspots;
+        for (size_t c = 0; c < seeds.size(); c++) {
+            Hotspot<R> hotspot;
+            hotspot.direction = glm::length(centroids[c]) > 0 ? glm::normalize(centroids[c]) : seeds[c];
+            hotspot.radiance = energies[c] * (1 / areas[c]);
+            hotspot.angle = std::acos(std::max<real>(-1, 1 - areas[c] / math::PI2));
+            hotspots.push_back(hotspot);
+        }
+        return hotspots;
+    }
+
+    /**
+     * Add analytic projection of the hotspot. Cap of constant radiance around the axis is zonal with coefficients
+     * 2 * PI * integral(P(l, x), cos(angle), 1) * K(l, 0), rotation to the hotspot direction turns them into
+     * 2 * PI * integral(P(l, x), cos(angle), 1) * y(l, m, direction)
+     * @param hotspot
+     * @param coefficients
+     */
+    template<class R>
+    void projectHotspot(const Hotspot<R> &hotspot, ShCoefficients<R> &coefficients) {
+        const auto n = order(coefficients);
+        const real c = std::cos(hotspot.angle);
+        std::vector<real> y(coefficients.size());
+        math::basis(n, hotspot.direction, y.data());
+        for (int l = 0; l <= n; l++) {
+            const real integral = l == 0 ? 1 - c : (math::P(l - 1, 0, c) - math::P(l + 1, 0, c)) / (2 * l + 1);
+            const R zonal = hotspot.radiance * (math::PI2 * integral);
+            for (int m = -l; m <= l; m++) {
+                const int index = l * (l + 1) + m;
+                coefficients[index] += zonal * y[index];
+            }
+        }
+    }
+
+    /**
+     * Encode environment with dominant sun: hotspots are projected analytically, the smooth residual is encoded with
+     * given method at lower mip level
+     * @param cubeMap
+     * @param order
+     * @param method method used for the residual
+     * @param samples samples used for the residual
+     * @param filtering
+     * @param threshold hotspot luminance relative to the average
+     * @param mip amount of times residual is downsampled before encoding
+     * @param hotspots receives extracted hotspots, if not null
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> encodeHotspots(const std::shared_ptr<CubeMap<F>> &cubeMap, uint16_t order,
+            SamplingMethod method, uint16_t samples, InterpolationMethod filtering, real threshold, uint16_t mip,
+            std::vector<Hotspot<R>> *hotspots = nullptr) {
+        auto residual = clone(*cubeMap);
+        const auto extracted = extractHotspots<R>(*residual, threshold);
+        for (uint16_t i = 0; i < mip && residual->getWidth() > 1; i++) {
+            residual = downsample(*residual);
+        }
+
+        ShCoefficients<R> coefficients = encode<R>(residual, order, method, samples, filtering);
+        for (auto &hotspot : extracted) {
+            projectHotspot(hotspot, coefficients);
+        }
+        if (hotspots) {
+            *hotspots = extracted;
+        }
+        return coefficients;
+    }
+}
+
+#endif //SH_HOTSPOT_H
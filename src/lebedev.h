@@ -0,0 +1,213 @@
+#ifndef SH_LEBEDEV_H
+#define SH_LEBEDEV_H
+
+#include <vector>
+#include <inttypes.h>
+
+#include "real.h"
+#include "shmath.h"
+
+namespace sh {
+    namespace lebedev {
+
+        /**
+         * Octahedral orbits used by Lebedev rules. Every generator point is expanded with all permutations and
+         * sign changes of its coordinates:
+         * A1 (1, 0, 0) - 6 points, A2 (0, a, a) - 12 points, A3 (a, a, a) - 8 points,
+         * B (l, l, m) - 24 points, C (p, q, 0) - 24 points, D (r, s, t) - 48 points
+         */
+        enum class Orbit : uint8_t {
+            A1,
+            A2,
+            A3,
+            B,
+            C,
+            D
+        };
+
+        struct Generator {
+            Orbit orbit;
+            real a;
+            real b;
+            real weight;
+        };
+
+        struct Rule {
+            uint16_t degree;
+            uint16_t points;
+            uint8_t size;
+            const Generator *generators;
+        };
+
+        struct QuadraturePoint {
+            vec3 direction;
+            real weight;
+        };
+
+        constexpr Generator RULE_6[] = {
+                {Orbit::A1, 0, 0, 1.0 / 6.0}
+        };
+
+        constexpr Generator RULE_14[] = {
+                {Orbit::A1, 0, 0, 1.0 / 15.0},
+                {Orbit::A3, 0, 0, 3.0 / 40.0}
+        };
+
+        constexpr Generator RULE_26[] = {
+                {Orbit::A1, 0, 0, 1.0 / 21.0},
+                {Orbit::A2, 0, 0, 4.0 / 105.0},
+                {Orbit::A3, 0, 0, 9.0 / 280.0}
+        };
+
+        constexpr Generator RULE_38[] = {
+                {Orbit::A1, 0, 0, 1.0 / 105.0},
+                {Orbit::A3, 0, 0, 9.0 / 280.0},
+                {Orbit::C, 0.4597008433809831, 0, 1.0 / 35.0}
+        };
+
+        constexpr Generator RULE_50[] = {
+                {Orbit::A1, 0, 0, 4.0 / 315.0},
+                {Orbit::A2, 0, 0, 64.0 / 2835.0},
+                {Orbit::A3, 0, 0, 27.0 / 1280.0},
+                {Orbit::B, 0.30151134457776363, 0, 14641.0 / 725760.0}
+        };
+
+        constexpr Generator RULE_74[] = {
+                {Orbit::A1, 0, 0, 0.00051306717973391566},
+                {Orbit::A2, 0, 0, 0.016604069565742025},
+                {Orbit::A3, 0, 0, -0.02958603896103873},
+                {Orbit::B, 0.48038446141526125, 0, 0.026576207082159405},
+                {Orbit::C, 0.32077264898077673, 0, 0.016522170993715692}
+        };
+
+        constexpr Generator RULE_86[] = {
+                {Orbit::A1, 0, 0, 0.011544011544011544},
+                {Orbit::A3, 0, 0, 0.01194390908585625},
+                {Orbit::B, 0.36960284645415037, 0, 0.011110555710603405},
+                {Orbit::B, 0.69435400660266633, 0, 0.011876501294537141},
+                {Orbit::C, 0.37424303909034129, 0, 0.011812303746904486}
+        };
+
+        constexpr Generator RULE_110[] = {
+                {Orbit::A1, 0, 0, 0.0038282704949367525},
+                {Orbit::A3, 0, 0, 0.0097937375124874954},
+                {Orbit::B, 0.69042104838229201, 0, 0.0099428148911780544},
+                {Orbit::B, 0.39568947305594138, 0, 0.0095954713360709865},
+                {Orbit::B, 0.1851156353447343, 0, 0.0082117372831912189},
+                {Orbit::C, 0.4783690288121521, 0, 0.009694996361663058}
+        };
+
+        constexpr Generator RULE_146[] = {
+                {Orbit::A1, 0, 0, 0.00059963136886225421},
+                {Orbit::A2, 0, 0, 0.0073729997186207583},
+                {Orbit::A3, 0, 0, 0.0072105153601444471},
+                {Orbit::B, 0.41749612279654602, 0, 0.0067538294863144759},
+                {Orbit::B, 0.15746766720390848, 0, 0.0075743941590539965},
+                {Orbit::B, 0.67644104001142646, 0, 0.0071163554931175542},
+                {Orbit::D, 0.14035538117131857, 0.44933283232695526, 0.0069910873533032721}
+        };
+
+        constexpr Generator RULE_170[] = {
+                {Orbit::A1, 0, 0, 0.0055448429020366037},
+                {Orbit::A2, 0, 0, 0.006071332770670926},
+                {Orbit::A3, 0, 0, 0.0063836747735150938},
+                {Orbit::B, 0.43189106967194218, 0, 0.0062016700065891401},
+                {Orbit::B, 0.67436014603627759, 0, 0.0063179290098138458},
+                {Orbit::B, 0.25512526211141284, 0, 0.0051833875877476199},
+                {Orbit::C, 0.26139313603358549, 0, 0.0054771433851372592},
+                {Orbit::D, 0.14466307443251022, 0.49904531617959591, 0.00596838398768125}
+        };
+
+        constexpr Generator RULE_194[] = {
+                {Orbit::A1, 0, 0, 0.0017823404472447116},
+                {Orbit::A2, 0, 0, 0.0057169059499771061},
+                {Orbit::A3, 0, 0, 0.0055733831788486845},
+                {Orbit::B, 0.28924656275754523, 0, 0.0051582377118053642},
+                {Orbit::B, 0.67129734426952214, 0, 0.0056087040825879616},
+                {Orbit::B, 0.12993354476500885, 0, 0.0041067770281694891},
+                {Orbit::B, 0.44469331787174399, 0, 0.005518771467273558},
+                {Orbit::C, 0.93831921813759034, 0, 0.0050518460646148365},
+                {Orbit::D, 0.52511857244364335, 0.15904171053835414, 0.0055302489162330848}
+        };
+
+        constexpr Rule RULES[] = {
+                {3, 6, 1, RULE_6},
+                {5, 14, 2, RULE_14},
+                {7, 26, 3, RULE_26},
+                {9, 38, 3, RULE_38},
+                {11, 50, 4, RULE_50},
+                {13, 74, 5, RULE_74},
+                {15, 86, 5, RULE_86},
+                {17, 110, 6, RULE_110},
+                {19, 146, 7, RULE_146},
+                {21, 170, 8, RULE_170},
+                {23, 194, 9, RULE_194}
+        };
+
+        /**
+         * Pick the smallest rule integrating product of two signals band-limited by given order exactly
+         * @param order
+         * @return nullptr if order is beyond embedded tables
+         */
+        const Rule *select(uint16_t order) {
+            for (const auto &rule : RULES) {
+                if (rule.degree >= 2 * order) {
+                    return &rule;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Expand generators of the rule into full point set. Weights are scaled to sum up to 4 * PI
+         * @param rule
+         * @return
+         */
+        std::vector<QuadraturePoint> points(const Rule &rule) {
+            std::vector<QuadraturePoint> result;
+            result.reserve(rule.points);
+            for (uint8_t g = 0; g < rule.size; g++) {
+                const Generator &generator = rule.generators[g];
+                real a = 0, b = 0, c = 0;
+                if (generator.orbit == Orbit::A1) {
+                    a = 1;
+                } else if (generator.orbit == Orbit::A2) {
+                    b = c = std::sqrt(0.5);
+                } else if (generator.orbit == Orbit::A3) {
+                    a = b = c = std::sqrt(1.0 / 3.0);
+                } else if (generator.orbit == Orbit::B) {
+                    a = b = generator.a;
+                    c = std::sqrt(1 - 2 * generator.a * generator.a);
+                } else if (generator.orbit == Orbit::C) {
+                    a = generator.a;
+                    b = std::sqrt(1 - generator.a * generator.a);
+                } else {
+                    a = generator.a;
+                    b = generator.b;
+                    c = std::sqrt(1 - generator.a * generator.a - generator.b * generator.b);
+                }
+
+                const vec3 permutations[] = {
+                        vec3(a, b, c), vec3(a, c, b), vec3(b, a, c),
+                        vec3(b, c, a), vec3(c, a, b), vec3(c, b, a)
+                };
+                const size_t first = result.size();
+                for (const auto &p : permutations) {
+                    for (int signs = 0; signs < 8; signs++) {
+                        const vec3 d(signs & 1u ? -p.x : p.x, signs & 2u ? -p.y : p.y, signs & 4u ? -p.z : p.z);
+                        bool duplicate = false;
+                        for (size_t i = first; i < result.size() && !duplicate; i++) {
+                            duplicate = result[i].direction == d;
+                        }
+                        if (!duplicate) {
+                            result.push_back({d, generator.weight * math::PI4});
+                        }
+                    }
+                }
+            }
+            return result;
+        }
+    }
+}
+
+#endif //SH_LEBEDEV_H
@@ -0,0 +1,180 @@
+#ifndef SH_PARALLEL_H
+#define SH_PARALLEL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+#include <algorithm>
+
+namespace sh {
+
+    /**
+     * Workers started once and kept waiting for jobs, so running a job costs a wake up instead of thread creation.
+     * Job is a range of chunks [0, count) taken one by one by workers and the calling thread. One job runs at a time:
+     * a job submitted while another one is running (by other thread or from inside of a chunk) is run by the caller
+     * alone. Exception thrown by a chunk is rethrown to the caller once all chunks are done
+     */
+    class ThreadPool {
+    protected:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::mutex submit;
+        std::condition_variable wake;
+        std::condition_variable done;
+        void (*task)(void *, size_t) = nullptr;
+        void *context = nullptr;
+        size_t count = 0;
+        size_t next = 0;
+        size_t finished = 0;
+        size_t generation = 0;
+        bool stopping = false;
+        std::exception_ptr failure;
+
+        template<class Body>
+        static void invoke(void *context, size_t chunk) {
+            (*static_cast<Body *>(context))(chunk);
+        }
+
+        /**
+         * Take chunks of current job until none is left, mutex is held by lock outside of chunks
+         */
+        void work(std::unique_lock<std::mutex> &lock) {
+            while (next < count) {
+                const size_t chunk = next++;
+                lock.unlock();
+                std::exception_ptr thrown;
+                try {
+                    task(context, chunk);
+                } catch (...) {
+                    thrown = std::current_exception();
+                }
+                lock.lock();
+                if (thrown && !failure) {
+                    failure = thrown;
+                }
+                if (++finished == count) {
+                    done.notify_all();
+                }
+            }
+        }
+
+    public:
+        /**
+         * @param threads amount of workers besides the calling thread
+         */
+        explicit ThreadPool(unsigned threads) {
+            workers.reserve(threads);
+            for (unsigned i = 0; i < threads; i++) {
+                workers.emplace_back([this]() {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    size_t seen = generation;
+                    for (;;) {
+                        wake.wait(lock, [this, &seen]() { return stopping || generation != seen; });
+                        if (stopping) {
+                            return;
+                        }
+                        seen = generation;
+                        work(lock);
+                    }
+                });
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * Amount of threads running a job, workers and the caller
+         * @return
+         */
+        unsigned size() const {
+            return (unsigned) workers.size() + 1;
+        }
+
+        /**
+         * Call body(chunk) for every chunk of [0, chunks) and wait until all are done, the first exception thrown
+         * by chunks is rethrown
+         * @param chunks
+         * @param body
+         */
+        template<class Body>
+        void run(size_t chunks, Body &body) {
+            std::unique_lock<std::mutex> exclusive(submit, std::try_to_lock);
+            if (!exclusive || workers.empty()) {
+                for (size_t chunk = 0; chunk < chunks; chunk++) {
+                    body(chunk);
+                }
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            task = &invoke<Body>;
+            context = &body;
+            count = chunks;
+            next = 0;
+            finished = 0;
+            generation++;
+            wake.notify_all();
+            work(lock);
+            done.wait(lock, [this]() { return finished == count; });
+            task = nullptr;
+            context = nullptr;
+            if (failure) {
+                std::exception_ptr thrown = failure;
+                failure = nullptr;
+                lock.unlock();
+                std::rethrow_exception(thrown);
+            }
+        }
+
+        /**
+         * Pool of hardware concurrency threads (with the caller) shared by parallelFor(), started on first use
+         * @return
+         */
+        static ThreadPool &shared() {
+            static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+    };
+
+    /**
+     * Split range [0, count) into contiguous chunks processed by threads of the shared ThreadPool, the calling
+     * thread takes part. Small ranges are processed in place. No thread is created and nothing is allocated per call
+     * @param count
+     * @param threads amount of chunks, 0 - threads of the pool
+     * @param grain min amount of items worth a chunk
+     * @param body called with (begin, end) of every chunk
+     */
+    template<class Body>
+    void parallelFor(size_t count, unsigned threads, size_t grain, Body &&body) {
+        if (threads == 0) {
+            threads = ThreadPool::shared().size();
+        }
+        threads = (unsigned) std::min<size_t>(threads, std::max<size_t>(1, count / std::max<size_t>(1, grain)));
+        if (threads <= 1) {
+            body((size_t) 0, count);
+            return;
+        }
+
+        const size_t chunk = (count + threads - 1) / threads;
+        auto range = [&body, chunk, count](size_t i) {
+            body(std::min(count, i * chunk), std::min(count, (i + 1) * chunk));
+        };
+        ThreadPool::shared().run(threads, range);
+    }
+}
+
+#endif //SH_PARALLEL_H
@@ -6,6 +6,8 @@
 #define SH_PIXEL_FORMAT_H
 
 #include <ostream>
+#include <algorithm>
+#include <cmath>
 
 #include "real.h"
 
@@ -48,11 +50,11 @@ namespace sh {
             return RGBStruct<T>(r * m, g * m, b * m);
         }
 
-        RGBStruct<T> operator/(const RGBStruct<T> &v) {
+        RGBStruct<T> operator/(const RGBStruct<T> &v) const {
             return {r / v.r, g / v.g, b / v.b};
         }
 
-        RGBStruct<T> operator/(T m) {
+        RGBStruct<T> operator/(T m) const {
             return {r / m, g / m, b / m};
         }
     };
@@ -80,7 +82,7 @@ namespace sh {
 
         RGBAStruct(T r, T g, T b, T a) : r(r), g(g), b(b), a(a) {}
 
-        RGBAStruct<T> operator+(const RGBAStruct<T> &v) {
+        RGBAStruct<T> operator+(const RGBAStruct<T> &v) const {
             return {r + v.r, g + v.g, b + v.b, a + v.a};
         }
 
@@ -92,23 +94,23 @@ namespace sh {
             return *this;
         }
 
-        RGBAStruct<T> operator-(const RGBAStruct<T> &v) {
+        RGBAStruct<T> operator-(const RGBAStruct<T> &v) const {
             return {r - v.r, g - v.g, b - v.b, a - v.a};
         }
 
-        RGBAStruct<T> operator*(const RGBAStruct<T> &v) {
+        RGBAStruct<T> operator*(const RGBAStruct<T> &v) const {
             return {r * v.r, g * v.g, b * v.b, a * v.a};
         }
 
-        RGBAStruct<T> operator*(T m) {
+        RGBAStruct<T> operator*(T m) const {
             return {r * m, g * m, b * m, a * m};
         }
 
-        RGBAStruct<T> operator/(const RGBAStruct<T> &v) {
+        RGBAStruct<T> operator/(const RGBAStruct<T> &v) const {
             return {r / v.r, g / v.g, b / v.b, a / v.a};
         }
 
-        RGBAStruct<T> operator/(T m) {
+        RGBAStruct<T> operator/(T m) const {
             return {r / m, g / m, b / m, a / m};
         }
     };
@@ -119,6 +121,62 @@ namespace sh {
         return stream;
     }
 
+    inline real maxComponent(real v) {
+        return v;
+    }
+
+    template<class T>
+    T maxComponent(const RGBStruct<T> &v) {
+        return std::max(std::max(v.r, v.g), v.b);
+    }
+
+    template<class T>
+    T maxComponent(const RGBAStruct<T> &v) {
+        return std::max(std::max(v.r, v.g), std::max(v.b, v.a));
+    }
+
+    inline real luminance(real v) {
+        return v;
+    }
+
+    template<class T>
+    real luminance(const RGBStruct<T> &v) {
+        return 0.2126 * v.r + 0.7152 * v.g + 0.0722 * v.b;
+    }
+
+    template<class T>
+    real luminance(const RGBAStruct<T> &v) {
+        return 0.2126 * v.r + 0.7152 * v.g + 0.0722 * v.b;
+    }
+
+    inline real squaredNorm(real v) {
+        return v * v;
+    }
+
+    template<class T>
+    real squaredNorm(const RGBStruct<T> &v) {
+        return v.r * v.r + v.g * v.g + v.b * v.b;
+    }
+
+    template<class T>
+    real squaredNorm(const RGBAStruct<T> &v) {
+        return v.r * v.r + v.g * v.g + v.b * v.b + v.a * v.a;
+    }
+
+    inline real componentSqrt(real v) {
+        return std::sqrt(v);
+    }
+
+    template<class T>
+    RGBStruct<T> componentSqrt(const RGBStruct<T> &v) {
+        return {std::sqrt(v.r), std::sqrt(v.g), std::sqrt(v.b)};
+    }
+
+    template<class T>
+    RGBAStruct<T> componentSqrt(const RGBAStruct<T> &v) {
+        return {std::sqrt(v.r), std::sqrt(v.g), std::sqrt(v.b), std::sqrt(v.a)};
+    }
+
     using RGB = RGBStruct<real>;
     using RGBA= RGBAStruct<real>;
     using RGBF = RGBStruct<float>;
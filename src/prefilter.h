@@ -0,0 +1,59 @@
+#ifndef SH_PREFILTER_H
+#define SH_PREFILTER_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <inttypes.h>
+
+#include "real.h"
+#include "CubeMap.h"
+#include "ShCoefficients.h"
+#include "convolution.h"
+#include "TexelBasis.h"
+#include "spherical_harmonic.h"
+
+namespace sh {
+
+    /**
+     * Roughness of mip level, levels are spread uniformly from 0 to 1
+     * @param level
+     * @param levels
+     * @return
+     */
+    real mipRoughness(uint16_t level, uint16_t levels) {
+        return levels > 1 ? real(level) / (levels - 1) : 0;
+    }
+
+    /**
+     * Specular prefiltered mip chain from one coefficient set: level k is the signal convolved with GGX specular
+     * lobe of mipRoughness(k, levels) decoded at max(1, size >> k). Only suits roughness the order resolves,
+     * sharp levels are as blurry as the signal itself. Every level has a size of its own, so TexelBasis tables built
+     * for the chain are dropped from the cache afterwards, tables cached before are kept
+     * @param coefficients
+     * @param size resolution of the first level
+     * @param levels
+     * @return
+     */
+    template<class R, class F>
+    std::vector<std::shared_ptr<CubeMap<F>>> prefilter(const ShCoefficients<R> &coefficients, int size,
+            uint16_t levels) {
+        const auto n = order(coefficients);
+        std::vector<std::shared_ptr<CubeMap<F>>> chain;
+        std::vector<uint16_t> built;
+        for (uint16_t level = 0; level < levels; level++) {
+            const auto levelSize = (uint16_t) std::max(1, size >> level);
+            if (!TexelBasis::cached(levelSize, n)) {
+                built.push_back(levelSize);
+            }
+            const std::vector<real> factors = kernel::specular(n, mipRoughness(level, levels));
+            chain.push_back(decode<R, F>(convolve(coefficients, factors), levelSize));
+        }
+        for (uint16_t levelSize : built) {
+            TexelBasis::release(levelSize, n);
+        }
+        return chain;
+    }
+}
+
+#endif //SH_PREFILTER_H
@@ -21,7 +21,11 @@ namespace sh {
     enum class SamplingMethod {
         Sphere,
         MonteCarlo,
-        Cubemap
+        Cubemap,
+        Quadrature,
+        Sobol,
+        Importance,
+        ControlVariate
     };
 
     enum class InterpolationMethod {
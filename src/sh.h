@@ -10,6 +10,19 @@
 #include "sampling.h"
 #include "shmath.h"
 #include "spherical_harmonic.h"
+#include "SphericalTransform.h"
+#include "hotspot.h"
+#include "batch_decode.h"
+#include "convolution.h"
+#include "prefilter.h"
+#include "ShRotation.h"
+#include "ShProduct.h"
+#include "PlanarCoefficients.h"
+#include "AdaptiveOrder.h"
+#include "RegionUpdate.h"
+#include "RealtimeEncoder.h"
+#include "TileMap.h"
+#include "Hemisphere.h"
 #include "CubeMapPolarFunction.h"
 #include "CliInput.h"
 
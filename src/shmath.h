@@ -6,7 +6,9 @@
 #define SH_MATH_H
 
 #include <cmath>
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include "real.h"
 
@@ -96,6 +98,129 @@ namespace sh {
             return std::sqrt(temp);
         }
 
+        /**
+         * Position of the normalized polynomial (l, m) inside of table filled by legendre()
+         * @param l band index [0, R]
+         * @param m index of polynomial inside of band [0, l]
+         * @return
+         */
+        inline int legendreIndex(int l, int m) {
+            return l * (l + 1) / 2 + m;
+        }
+
+        const int RECURRENCE_ORDER = 64;
+
+        /**
+         * Coefficients of the recurrence over normalized Associated Legendre Polynomials:
+         * K(l,m) * P(l,m,x) = a * (x * K(l-1,m) * P(l-1,m,x) - b * K(l-2,m) * P(l-2,m,x)), l >= m + 2.
+         * Computed on every call, see recurrence() for tabulated ones
+         * @param l
+         * @param m
+         * @param a
+         * @param b
+         */
+        inline void computeRecurrence(int l, int m, real &a, real &b) {
+            a = std::sqrt((4.0 * l * l - 1) / (l * l - m * m));
+            b = std::sqrt(((l - 1.0) * (l - 1) - m * m) / (4.0 * (l - 1) * (l - 1) - 1));
+        }
+
+        /**
+         * Coefficients of the recurrence used by legendre() and basis(), see computeRecurrence().
+         * Tabulated once up to RECURRENCE_ORDER, computed on the fly beyond
+         * @param l
+         * @param m
+         * @param a
+         * @param b
+         */
+        inline void recurrence(int l, int m, real &a, real &b) {
+            struct Table {
+                std::vector<real> a, b;
+
+                Table() {
+                    const int size = legendreIndex(RECURRENCE_ORDER, RECURRENCE_ORDER) + 1;
+                    a.resize(size);
+                    b.resize(size);
+                    for (int l = 0; l <= RECURRENCE_ORDER; l++) {
+                        for (int m = 0; m + 2 <= l; m++) {
+                            computeRecurrence(l, m, a[legendreIndex(l, m)], b[legendreIndex(l, m)]);
+                        }
+                    }
+                }
+            };
+            static const Table table;
+
+            if (l <= RECURRENCE_ORDER) {
+                a = table.a[legendreIndex(l, m)];
+                b = table.b[legendreIndex(l, m)];
+            } else {
+                computeRecurrence(l, m, a, b);
+            }
+        }
+
+        /**
+         * Evaluate all normalized Associated Legendre Polynomials K(l,m) * P(l,m,x) up to given order at once.
+         * Uses stable recurrences over normalized values, so no factorials are involved and high orders don't overflow
+         * @param order max band index
+         * @param x
+         * @param out table of (order + 1) * (order + 2) / 2 values, see legendreIndex()
+         */
+        void legendre(int order, real x, real *out) {
+            const real somx2 = std::sqrt((1 - x) * (1 + x));
+            real pmm = std::sqrt(1 / PI4);
+            for (int m = 0; m <= order; m++) {
+                if (m > 0) {
+                    pmm *= -std::sqrt((2 * m + 1) / (2.0 * m)) * somx2;
+                }
+                out[legendreIndex(m, m)] = pmm;
+                if (m == order) {
+                    break;
+                }
+                real pll2 = pmm;
+                real pll1 = std::sqrt(2.0 * m + 3) * x * pmm;
+                out[legendreIndex(m + 1, m)] = pll1;
+                for (int l = m + 2; l <= order; l++) {
+                    real a, b;
+                    recurrence(l, m, a, b);
+                    const real pll = a * (x * pll1 - b * pll2);
+                    out[legendreIndex(l, m)] = pll;
+                    pll2 = pll1;
+                    pll1 = pll;
+                }
+            }
+        }
+
+        /**
+         * Compute nodes and weights of Gauss-Legendre quadrature on [-1, 1]
+         * @param n number of nodes
+         * @param nodes
+         * @param weights
+         */
+        void gaussLegendre(int n, std::vector<real> &nodes, std::vector<real> &weights) {
+            nodes.resize(n);
+            weights.resize(n);
+            for (int i = 0; i < (n + 1) / 2; i++) {
+                double x = std::cos(PI * (i + 0.75) / (n + 0.5));
+                double dp = 1;
+                for (int iteration = 0; iteration < 100; iteration++) {
+                    double p0 = 1, p1 = x;
+                    for (int k = 2; k <= n; k++) {
+                        const double p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+                        p0 = p1;
+                        p1 = p2;
+                    }
+                    dp = n * (x * p1 - p0) / (x * x - 1);
+                    const double dx = p1 / dp;
+                    x -= dx;
+                    if (std::abs(dx) < 1e-15) {
+                        break;
+                    }
+                }
+                nodes[i] = (real) x;
+                nodes[n - 1 - i] = (real) -x;
+                weights[i] = weights[n - 1 - i] = (real) (2 / ((1 - x * x) * dp * dp));
+            }
+        }
+
         template<class T>
         bool equal(T a, T b , const T epsilon = std::numeric_limits<T>::epsilon()) {
             return std::abs(b - a) < epsilon;
@@ -124,6 +249,53 @@ namespace sh {
             return result;
         }
 
+        /**
+         * Evaluate all Spherical Harmonic basis functions up to given order at unit direction.
+         * Same values as y(l, m, phi, tetta) but without trigonometric calls: cos(m * phi) and sin(m * phi) are
+         * obtained by recurrence from the direction itself
+         * @param order max band index
+         * @param dir unit direction (OpenGL space)
+         * @param out (order + 1)^2 values, index l * (l + 1) + m
+         */
+        void basis(int order, const vec3 &dir, real *out) {
+            const real x = dir.y;
+            const real somx2 = std::sqrt(std::max<real>(0, (1 - x) * (1 + x)));
+            const real cosPhi = somx2 > 0 ? dir.z / somx2 : 1;
+            const real sinPhi = somx2 > 0 ? dir.x / somx2 : 0;
+
+            real pmm = std::sqrt(1 / PI4);
+            real cm = 1, sm = 0;
+            for (int m = 0; m <= order; m++) {
+                if (m > 0) {
+                    pmm *= -std::sqrt((2 * m + 1) / (2.0 * m)) * somx2;
+                    const real c = cm * cosPhi - sm * sinPhi;
+                    sm = sm * cosPhi + cm * sinPhi;
+                    cm = c;
+                }
+                const real fc = m == 0 ? 1 : SQRT2 * cm, fs = SQRT2 * sm;
+
+                real pll2 = 0, pll1 = pmm;
+                for (int l = m; l <= order; l++) {
+                    real pll = pmm;
+                    if (l == m + 1) {
+                        pll = std::sqrt(2.0 * m + 3) * x * pmm;
+                    } else if (l > m + 1) {
+                        real a, b;
+                        recurrence(l, m, a, b);
+                        pll = a * (x * pll1 - b * pll2);
+                    }
+                    if (l > m) {
+                        pll2 = pll1;
+                        pll1 = pll;
+                    }
+                    out[l * (l + 1) + m] = pll * fc;
+                    if (m > 0) {
+                        out[l * (l + 1) - m] = pll * fs;
+                    }
+                }
+            }
+        }
+
         float radicalInverse_VdC(uint32_t bits) {
             bits = (bits << 16u) | (bits >> 16u);
             bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
@@ -141,6 +313,59 @@ namespace sh {
             return vec2(PI2 * ey, 2 * std::acos(std::sqrt(1 - ex)));
         }
 
+        uint32_t reverseBits(uint32_t bits) {
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return bits;
+        }
+
+        uint32_t hash(uint32_t x) {
+            x ^= x >> 16u;
+            x *= 0x7feb352du;
+            x ^= x >> 15u;
+            x *= 0x846ca68bu;
+            x ^= x >> 16u;
+            return x;
+        }
+
+        /**
+         * Owen scrambling of 32 bit fixed point number, hash based (Laine-Karras permutation applied to reversed bits)
+         * @param bits
+         * @param seed
+         * @return
+         */
+        uint32_t owenScramble(uint32_t bits, uint32_t seed) {
+            bits = reverseBits(bits);
+            bits += seed;
+            bits ^= bits * 0x6c50b47cu;
+            bits ^= bits * 0xb82f1e52u;
+            bits ^= bits * 0xc7afe638u;
+            bits ^= bits * 0x8d22f6e6u;
+            return reverseBits(bits);
+        }
+
+        /**
+         * Point of 2d Sobol sequence scrambled with given seed. Every seed gives an independent randomization of the same
+         * low discrepancy set, first 2^k points of each are well stratified
+         * @param i index of point
+         * @param seed
+         * @return point in [0, 1)^2
+         */
+        vec2 sobol2d(uint32_t i, uint32_t seed) {
+            uint32_t x = reverseBits(i), y = 0;
+            for (uint32_t v = 1u << 31u; i; i >>= 1u, v ^= v >> 1u) {
+                if (i & 1u) {
+                    y ^= v;
+                }
+            }
+            x = owenScramble(x, hash(seed * 2u));
+            y = owenScramble(y, hash(seed * 2u + 1u));
+            return vec2(x * 2.3283064365386963e-10, y * 2.3283064365386963e-10);
+        }
+
     }
 }
 #endif //SH_MATH_H
@@ -11,23 +11,26 @@
 #include <iostream>
 #include <map>
 #include <cmath>
+#include <algorithm>
 
 #include "real.h"
 #include "CubeMap.h"
 #include "sampling.h"
 #include "shmath.h"
 #include "CubeMapPolarFunction.h"
+#include "ShCoefficients.h"
+#include "SphericalTransform.h"
+#include "lebedev.h"
+#include "CubeMapDistribution.h"
+#include "TexelIntegrals.h"
+#include "TexelBasis.h"
+#include "CubeMapSymmetry.h"
+#include "QuadraticForm.h"
+#include "FixedOrder.h"
+#include "TileMap.h"
 
 namespace sh {
 
-    template<class R>
-    using ShCoefficients = std::vector<R>;
-
-    template<class R>
-    uint16_t order(const ShCoefficients<R> &coefficients) {
-        return (uint16_t) (std::sqrt(coefficients.size()) - 1u);
-    }
-
     template<class R>
     R estimateSpherical(const math::PolarFunction<R> &polarFunction, int l, int m, uint16_t divisions = 64) {
         real dPhi = math::PI2 / divisions, dTetta = math::PI2 / divisions;
@@ -58,18 +61,278 @@ namespace sh {
         return estimation * factor;
     }
 
-    real projectedArea(real s, real t) {
-        return std::atan2(s * t, std::sqrt(s * s + t * t + 1));
+    /**
+     * Estimate all coefficients at once with Lebedev quadrature. Rule is picked from order so that band-limited
+     * signals are integrated exactly with the minimal amount of points. Orders beyond embedded rules fall back to
+     * minimal Gauss-Legendre product grid, which is exact as well
+     * @param polarFunction
+     * @param order
+     * @return
+     */
+    template<class R>
+    ShCoefficients<R> estimateQuadrature(const math::PolarFunction<R> &polarFunction, uint16_t order) {
+        const lebedev::Rule *rule = lebedev::select(order);
+        if (!rule) {
+            SphericalTransform<R> transform(order, 0);
+            return transform(polarFunction);
+        }
+
+        ShCoefficients<R> coefficients((order + 1u) * (order + 1u), R(0));
+        std::vector<real> y(coefficients.size());
+        for (const auto &point : lebedev::points(*rule)) {
+            const vec2 angles = math::cartesianToSpherical(point.direction);
+            const R sample = polarFunction(angles.x, angles.y) * point.weight;
+            math::basis(order, point.direction, y.data());
+            for (size_t i = 0; i < coefficients.size(); i++) {
+                coefficients[i] += sample * y[i];
+            }
+        }
+        return coefficients;
     }
 
-    real solidAngle(real s, real t, real ds, real dt) {
-        ds = ds * 0.5;
-        dt = dt * 0.5;
-        real C = projectedArea(s + ds, t + dt);
-        real A = projectedArea(s - ds, t - dt);
-        real B = projectedArea(s + ds, t - dt);
-        real D = projectedArea(s - ds, t + dt);
-        return A - B + C - D;
+    template<class R>
+    struct ProgressiveEstimate {
+        ShCoefficients<R> coefficients;
+        ShCoefficients<R> error;
+        uint32_t samples = 0;
+    };
+
+    /**
+     * Randomized quasi Monte Carlo estimation with several independently Owen-scrambled Sobol sequences.
+     * Every round doubles amount of points per scramble (previous points are kept), scrambles give independent
+     * unbiased estimations, so their spread yields standard error of every coefficient. Stops as soon as all errors
+     * are under tolerance or sample budget is exhausted
+     * @param polarFunction
+     * @param order
+     * @param tolerance max standard error allowed for any coefficient and channel
+     * @param maxSamples total sample budget over all scrambles, every scramble takes at least one point
+     * @param scrambles amount of independent randomizations (>= 2)
+     * @return coefficients, per-coefficient standard error and number of samples taken
+     */
+    template<class R>
+    ProgressiveEstimate<R> estimateProgressive(const math::PolarFunction<R> &polarFunction, uint16_t order,
+            real tolerance, uint32_t maxSamples, uint16_t scrambles = 8) {
+        const size_t n = (order + 1u) * (order + 1u);
+        std::vector<ShCoefficients<R>> sums(scrambles, ShCoefficients<R>(n, R(0)));
+        std::vector<real> y(n);
+
+        ProgressiveEstimate<R> estimate;
+        uint32_t taken = 0;
+        const uint32_t first = std::max<uint32_t>(1, std::min<uint32_t>(32, maxSamples / scrambles));
+        for (uint32_t count = first; ; count *= 2) {
+            for (uint16_t k = 0; k < scrambles; k++) {
+                for (uint32_t i = taken; i < count; i++) {
+                    const vec2 e = math::sobol2d(i, k);
+                    const vec2 angles = math::sampleSphere(e.x, e.y);
+                    const R sample = polarFunction(angles.x, angles.y);
+                    math::basis(order, math::sphericalToCartesian(angles.x, angles.y), y.data());
+                    for (size_t j = 0; j < n; j++) {
+                        sums[k][j] += sample * y[j];
+                    }
+                }
+            }
+            taken = count;
+            estimate.samples = taken * scrambles;
+
+            const real factor = math::PI4 / taken;
+            estimate.coefficients.assign(n, R(0));
+            estimate.error.assign(n, R(0));
+            for (uint16_t k = 0; k < scrambles; k++) {
+                for (size_t j = 0; j < n; j++) {
+                    estimate.coefficients[j] += sums[k][j] * (factor / scrambles);
+                }
+            }
+            real worst = 0;
+            for (size_t j = 0; j < n; j++) {
+                R variance(0);
+                for (uint16_t k = 0; k < scrambles; k++) {
+                    const R d = sums[k][j] * factor - estimate.coefficients[j];
+                    variance += d * d;
+                }
+                estimate.error[j] = componentSqrt(variance * (1.0 / (scrambles * (scrambles - 1.0))));
+                worst = std::max(worst, maxComponent(estimate.error[j]));
+            }
+
+            if (worst <= tolerance || (uint64_t) count * 2 * scrambles > maxSamples) {
+                break;
+            }
+        }
+        return estimate;
+    }
+
+    /**
+     * Importance sampled Monte Carlo estimation: directions are drawn proportionally to texel luminance, every sample
+     * is weighted by inverse of its density. Bright small sources (sun) are hit by most of samples instead of being
+     * missed, which drastically reduces variance for HDR environments
+     * @param distribution luminance distribution of the cubemap being encoded
+     * @param order
+     * @param samples
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> estimateImportance(const CubeMapDistribution<F> &distribution, uint16_t order, uint32_t samples) {
+        ShCoefficients<R> coefficients((order + 1u) * (order + 1u), R(0));
+        std::vector<real> y(coefficients.size());
+        for (uint32_t i = 0; i < samples; i++) {
+            const vec2 u = math::sobol2d(i, 0), jitter = math::sobol2d(i, 1);
+            const CubeMapSample<F> sample = distribution.sample(u.x, u.y, jitter);
+            const R value = R(sample.value) * (1 / (sample.pdf * samples));
+            math::basis(order, sample.direction, y.data());
+            for (size_t j = 0; j < coefficients.size(); j++) {
+                coefficients[j] += value * y[j];
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Project bands first..order at once by walking texels of the cubemap. Every texel is weighted by exact integrals
+     * of basis functions over its area (see TexelIntegrals), so small faces resolve high orders as well.
+     * Faces too large for tables use basis at texel center multiplied by texel solid angle.
+     * Basis is evaluated on canonical texels only, texels of the same symmetry orbit are summed up per group element
+     * and turned into coefficients with sign and index tables at the end. Bands are independent projections, so
+     * only coefficients of requested bands are accumulated
+     * @param cubemap
+     * @param first lowest band to project
+     * @param order
+     * @param build whether to build missing integral tables, otherwise only tables already cached are used and
+     * texel centers are taken without them, tables cost as much to build as they save for a single projection
+     * @return (order + 1)^2 coefficients, bands below first are zero
+     */
+    template<class R, class F>
+    ShCoefficients<R> projectBands(CubeMap<F> &cubemap, uint16_t first, uint16_t order, bool build = true) {
+        const size_t n = (order + 1u) * (order + 1u);
+        const size_t lowest = (size_t) first * first;
+        if (!cubemap.isSquare()) {
+            throw std::runtime_error("projectBands: cubemap faces have to be square and of the same size");
+        }
+        const int size = cubemap.getWidth();
+        std::shared_ptr<const TexelIntegrals> integrals;
+        if (build && TexelIntegrals::affordable((uint16_t) size, order)) {
+            integrals = TexelIntegrals::get((uint16_t) size, order);
+        } else if (!build) {
+            integrals = TexelIntegrals::find((uint16_t) size, order);
+        }
+
+        std::map<CubeMapFaceEnum, const F *> faces;
+        for (auto &item : faceTransforms()) {
+            faces[item.first] = cubemap[item.first]->getData();
+        }
+
+        std::vector<ShCoefficients<R>> sums(symmetry::ELEMENTS, ShCoefficients<R>(n, R(0)));
+        std::vector<real> center(n);
+        const real d = 2.0 / size;
+        size_t index = 0;
+        symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+            const real *y = center.data();
+            if (integrals) {
+                y = (*integrals)(index++);
+            } else {
+                const real s = -1 + d * (orbit.texel.j + 0.5), t = -1 + d * (orbit.texel.i + 0.5);
+                math::basis(order, orbit.direction, center.data());
+                const real dw = solidAngle(std::abs(s), std::abs(t), d, d);
+                for (size_t c = lowest; c < n; c++) {
+                    center[c] *= dw;
+                }
+            }
+            for (uint8_t k = 0; k < orbit.size; k++) {
+                const symmetry::Texel &texel = orbit.images[k].texel;
+                const R sample = R(faces[texel.face][texel.i * size + texel.j]);
+                ShCoefficients<R> &sum = sums[orbit.images[k].element];
+                for (size_t c = lowest; c < n; c++) {
+                    sum[c] += sample * y[c];
+                }
+            }
+        });
+
+        // group elements keep bands, so indices stay within requested bands
+        const symmetry::BasisAction action(order);
+        ShCoefficients<R> coefficients(n, R(0));
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t c = lowest; c < n; c++) {
+                coefficients[c] += sums[element][action.index(element, c)] * action.sign(element, c);
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Project all coefficients at once by walking texels of the cubemap, see projectBands().
+     * Orders up to FIXED_ORDER are projected by fixed order kernel
+     * @param cubemap
+     * @param order
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> projectCubeMap(CubeMap<F> &cubemap, uint16_t order) {
+        if (order <= FIXED_ORDER) {
+            return dispatch(order, [&cubemap](auto fixed) {
+                return dynamic(projectCubeMap<R, decltype(fixed)::value>(cubemap));
+            });
+        }
+        return projectBands<R, F>(cubemap, 0, order);
+    }
+
+    /**
+     * Raise order of existing coefficients of the cubemap: bands up to order(coefficients) are kept as they are,
+     * only the missing bands are projected. Integral tables are used if the cubemap size was projected before,
+     * otherwise new bands are weighted at texel centers, so extending costs less than projecting all bands anew.
+     * Then the result is not equal to projectCubeMap() of the new order: kept bands come from one quadrature and
+     * new bands from the other
+     * @param coefficients
+     * @param cubemap
+     * @param order new order, lower or equal one truncates coefficients
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> extend(const ShCoefficients<R> &coefficients, CubeMap<F> &cubemap, uint16_t order) {
+        if (coefficients.empty()) {
+            return projectCubeMap<R, F>(cubemap, order);
+        }
+        const uint16_t current = sh::order(coefficients);
+        const size_t n = (order + 1u) * (order + 1u);
+        if (order <= current) {
+            return ShCoefficients<R>(coefficients.begin(), coefficients.begin() + n);
+        }
+        ShCoefficients<R> extended = projectBands<R, F>(cubemap, (uint16_t) (current + 1u), order, false);
+        std::copy(coefficients.begin(), coefficients.begin() + (current + 1u) * (current + 1u), extended.begin());
+        return extended;
+    }
+
+    /**
+     * Monte Carlo estimation with control variate. Signal reconstructed from control coefficients has exactly those
+     * coefficients as its projection, so only residual between the signal and reconstruction is sampled.
+     * Estimation stays unbiased for any control, the closer control is the lower is variance
+     * @param polarFunction
+     * @param control coefficients of coarse projection of the same signal, define the order of estimation
+     * @param samples
+     * @return
+     */
+    template<class R>
+    ShCoefficients<R> estimateControlVariate(const math::PolarFunction<R> &polarFunction,
+            const ShCoefficients<R> &control, uint16_t samples) {
+        const auto n = order(control);
+        ShCoefficients<R> residual(control.size(), R(0));
+        std::vector<real> y(control.size());
+        for (uint16_t i = 0; i < samples; i++) {
+            const vec2 e = math::hammersley2d(i, samples);
+            const vec2 angles = math::sampleSphere(e.x, e.y);
+            math::basis(n, math::sphericalToCartesian(angles.x, angles.y), y.data());
+            R reconstruction(0);
+            for (size_t k = 0; k < control.size(); k++) {
+                reconstruction += control[k] * y[k];
+            }
+            const R sample = polarFunction(angles.x, angles.y) - reconstruction;
+            for (size_t k = 0; k < control.size(); k++) {
+                residual[k] += sample * y[k];
+            }
+        }
+
+        ShCoefficients<R> coefficients(control);
+        for (size_t k = 0; k < control.size(); k++) {
+            coefficients[k] += residual[k] * (math::PI4 / samples);
+        }
+        return coefficients;
     }
 
     template<class R, class F>
@@ -77,14 +340,7 @@ namespace sh {
         using namespace std;
         using namespace math;
 
-        const map<CubeMapFaceEnum, mat3> transformLookup = {
-                {CubeMapFaceEnum::PositiveX, mat3(-axis::z, axis::y, -axis::x)},
-                {CubeMapFaceEnum::NegativeX, mat3(axis::z, axis::y, axis::x)},
-                {CubeMapFaceEnum::PositiveY, mat3(axis::x, -axis::z, -axis::y)},
-                {CubeMapFaceEnum::NegativeY, mat3(axis::x, axis::z, axis::y)},
-                {CubeMapFaceEnum::PositiveZ, mat3(axis::x, axis::y, -axis::z)},
-                {CubeMapFaceEnum::NegativeZ, mat3(-axis::x, axis::y, axis::z)}
-        };
+        const map<CubeMapFaceEnum, mat3> &transformLookup = faceTransforms();
 
         R estimation(0);
         const int w = cubemap->getWidth(), h = cubemap->getHeight();
@@ -109,9 +365,42 @@ namespace sh {
         return estimation;
     }
 
+    /**
+     * Encode with control variate: cubemap downsampled to coarse size is projected exactly, Monte Carlo samples of
+     * full resolution cubemap are spent on the residual only
+     * @param cubeMap
+     * @param order
+     * @param samples
+     * @param filtering
+     * @param coarseSize max face size of the control cubemap
+     * @return
+     */
+    template<class R, class F>
+    ShCoefficients<R> encodeControlVariate(const std::shared_ptr<CubeMap<F>> &cubeMap, uint16_t order,
+            uint16_t samples, InterpolationMethod filtering, int coarseSize = 16) {
+        std::shared_ptr<CubeMap<F>> coarse = cubeMap;
+        while (coarse->getWidth() > coarseSize || coarse->getHeight() > coarseSize) {
+            coarse = downsample(*coarse);
+        }
+        const ShCoefficients<R> control = projectCubeMap<R>(*coarse, order);
+        CubeMapPolarFunction<R, F> polarFunction(cubeMap, filtering);
+        return estimateControlVariate<R>(polarFunction, control, samples);
+    }
+
+    /**
+     * Encode cubemap with given sampling method
+     * @param cubeMap
+     * @param order
+     * @param method
+     * @param samples
+     * @param filtering
+     * @param tiles tile map of the cubemap for 'cubemap' method, best built once when the cubemap is loaded;
+     * built here if missing
+     * @return
+     */
     template<class R, class F>
     ShCoefficients<R> encode(const std::shared_ptr<CubeMap<F>> &cubeMap, uint16_t order, SamplingMethod method,
-            uint16_t samples, InterpolationMethod filtering) {
+            uint16_t samples, InterpolationMethod filtering, const TileMap<F> *tiles = nullptr) {
 
         ShCoefficients<R> coefficients((order + 1u) * (order + 1u));
         if (method == SamplingMethod::MonteCarlo) {
@@ -125,19 +414,32 @@ namespace sh {
         } else if (method == SamplingMethod::Sphere) {
             CubeMapPolarFunction<R, F> polarFunction(cubeMap, filtering);
             const auto divisions = (uint16_t) std::sqrt(2.0 * samples);
+            SphericalTransform<R> transform(order, divisions);
+            coefficients = transform(polarFunction);
+        } else if (method == SamplingMethod::Quadrature) {
+            CubeMapPolarFunction<R, F> polarFunction(cubeMap, filtering);
+            coefficients = estimateQuadrature<R>(polarFunction, order);
+        } else if (method == SamplingMethod::Sobol) {
+            CubeMapPolarFunction<R, F> polarFunction(cubeMap, filtering);
+            coefficients = estimateProgressive<R>(polarFunction, order, 0, samples).coefficients;
+        } else if (method == SamplingMethod::Importance) {
+            CubeMapDistribution<F> distribution(cubeMap);
+            coefficients = estimateImportance<R>(distribution, order, samples);
+        } else if (method == SamplingMethod::ControlVariate) {
+            coefficients = encodeControlVariate<R>(cubeMap, order, samples, filtering);
+        } else if (!cubeMap->isSquare()) {
+            // texel walks expect square faces of the same size, others are estimated coefficient by coefficient
             for (int l = 0; l <= order; l++) {
                 for (int m = -l; m <= l; m++) {
-                    int index = l * (l + 1) + m;
-                    coefficients[index] = estimateSpherical<R>(polarFunction, l, m, divisions);
+                    coefficients[l * (l + 1) + m] = estimateCubeMap<R>(cubeMap, l, m);
                 }
             }
+        } else if (TexelIntegrals::affordable(cubeMap->getWidth(), order)) {
+            // zero and constant tiles are not walked texel by texel
+            coefficients = tiles ? projectTiles<R>(*cubeMap, *tiles, order) :
+                           projectTiles<R>(*cubeMap, TileMap<F>(*cubeMap), order);
         } else {
-            for (int l = 0; l <= order; l++) {
-                for (int m = -l; m <= l; m++) {
-                    int index = l * (l + 1) + m;
-                    coefficients[index] = estimateCubeMap<R>(cubeMap, l, m);
-                }
-            }
+            coefficients = projectCubeMap<R>(*cubeMap, order);
         }
 
         return coefficients;
@@ -145,26 +447,105 @@ namespace sh {
 
 
     /**
-     * Get decoded value by parameterized spherical coordinates
+     * Encode with scrambled Sobol sampling until every coefficient's standard error is under tolerance
+     * @param cubeMap
+     * @param order
+     * @param tolerance
+     * @param maxSamples
+     * @param filtering
+     * @return
+     */
+    template<class R, class F>
+    ProgressiveEstimate<R> encodeProgressive(const std::shared_ptr<CubeMap<F>> &cubeMap, uint16_t order,
+            real tolerance, uint32_t maxSamples, InterpolationMethod filtering) {
+        CubeMapPolarFunction<R, F> polarFunction(cubeMap, filtering);
+        return estimateProgressive<R>(polarFunction, order, tolerance, maxSamples);
+    }
+
+    /**
+     * Get decoded value at unit direction.
+     * For every m the sum over l of coefficients times normalized Legendre polynomials is evaluated with Clenshaw
+     * backward recurrence, so neither basis functions nor polynomials are formed: y(l) = c(l) + a(l+1) * x * y(l+1) -
+     * a(l+2) * b(l+2) * y(l+2) and the sum is K(m,m) * P(m,m,x) * y(m), since the first step of forward recurrence has
+     * no second term. cos(m * phi) and sin(m * phi) are advanced along with m.
+     * Orders up to FIXED_ORDER are evaluated by closed form basis
      * @param coefficients
-     * @param phi
-     * @param tetta
+     * @param direction
      * @return
      */
     template<class R>
-    R decode(const ShCoefficients<R> &coefficients, real phi, real tetta) {
-        const auto n = order(coefficients);
+    R decode(const ShCoefficients<R> &coefficients, const vec3 &direction) {
+        const int n = order(coefficients);
+        if (n <= FIXED_ORDER) {
+            return dispatch((uint16_t) n, [&](auto fixed) {
+                return decode<decltype(fixed)::value>(coefficients.data(), direction);
+            });
+        }
+
+        const real x = direction.y;
+        const real somx2 = std::sqrt(std::max<real>(0, (1 - x) * (1 + x)));
+        const real cosPhi = somx2 > 0 ? direction.z / somx2 : 1;
+        const real sinPhi = somx2 > 0 ? direction.x / somx2 : 0;
+
         R decoded(0);
-        for (int l = 0; l <= n; l++) {
-            for (int m = -l; m <= l; m++) {
-                int index = l * (l + 1) + m;
-                R c = coefficients[index];
-                decoded += c * math::y(l, m, phi, tetta);
+        real pmm = std::sqrt(1 / math::PI4);
+        real cm = 1, sm = 0;
+        for (int m = 0; m <= n; m++) {
+            if (m > 0) {
+                pmm *= -std::sqrt((2 * m + 1) / (2.0 * m)) * somx2;
+                const real c = cm * cosPhi - sm * sinPhi;
+                sm = sm * cosPhi + cm * sinPhi;
+                cm = c;
+            }
+
+            // coefficients beyond the order are zero, so recurrence terms there don't matter as long as finite
+            R cos1(0), cos2(0), sin1(0), sin2(0);
+            real a2, b2, a1 = 0, b1 = 0;
+            math::recurrence(n + 2, m, a2, b2);
+            for (int l = n; l >= m; l--) {
+                real alpha;
+                if (l > m) {
+                    math::recurrence(l + 1, m, a1, b1);
+                    alpha = a1 * x;
+                } else {
+                    alpha = std::sqrt(2.0 * m + 3) * x;
+                }
+                const real beta = -a2 * b2;
+
+                // the term with y(l + 1) is added last: it's the only one depending on the previous step
+                const R c = coefficients[l * (l + 1) + m] + cos2 * beta + cos1 * alpha;
+                cos2 = cos1;
+                cos1 = c;
+                if (m > 0) {
+                    const R s = coefficients[l * (l + 1) - m] + sin2 * beta + sin1 * alpha;
+                    sin2 = sin1;
+                    sin1 = s;
+                }
+                a2 = a1;
+                b2 = b1;
+            }
+
+            if (m == 0) {
+                decoded += cos1 * pmm;
+            } else {
+                decoded += (cos1 * cm + sin1 * sm) * (math::SQRT2 * pmm);
             }
         }
         return decoded;
     }
 
+    /**
+     * Get decoded value by parameterized spherical coordinates
+     * @param coefficients
+     * @param phi
+     * @param tetta
+     * @return
+     */
+    template<class R>
+    R decode(const ShCoefficients<R> &coefficients, real phi, real tetta) {
+        return decode<R>(coefficients, math::sphericalToCartesian(phi, tetta));
+    }
+
     /**
      * Convert encoded signal into cubemap
      * @tparam F
@@ -178,37 +559,67 @@ namespace sh {
         using namespace glm;
         using namespace math;
 
-        const map<CubeMapFaceEnum, mat3> transformLookup = {
-                {CubeMapFaceEnum::PositiveX, mat3(-axis::z, axis::y, -axis::x)},
-                {CubeMapFaceEnum::NegativeX, mat3(axis::z, axis::y, axis::x)},
-                {CubeMapFaceEnum::PositiveY, mat3(axis::x, -axis::z, -axis::y)},
-                {CubeMapFaceEnum::NegativeY, mat3(axis::x, axis::z, axis::y)},
-                {CubeMapFaceEnum::PositiveZ, mat3(axis::x, axis::y, -axis::z)},
-                {CubeMapFaceEnum::NegativeZ, mat3(-axis::x, axis::y, axis::z)}
-        };
-
-        real dt = 2.0 / size, ds = 2.0 / size;
         map<CubeMapFaceEnum, shared_ptr<PixelArray<F>>> faces;
-        for (auto &item : transformLookup) {
-            const auto face = item.first;
-            const auto transform = item.second;
-
-            auto bitmap = make_shared<PixelArray<F>>(new F[size * size], size, size);
+        for (auto &item : faceTransforms()) {
+            faces[item.first] = make_shared<PixelArray<F>>(new F[size * size], size, size);
+        }
 
-            real s, t = -1 + dt * 0.5;
-            for (int y = 0; y < size; y++) {
-                s = -1 + ds * 0.5;
-                for (int x = 0; x < size; x++) {
-                    vec3 r = transform * normalize(vec3(s, t, -1));
-                    vec2 angles = math::cartesianToSpherical(r);
-                    const auto v = decode<R>(coefficients, angles.x, angles.y);
-                    (*bitmap)[y][x] = F(v);
-                    s += ds;
+        // order 2 signal is a quadratic form of direction
+        if (coefficients.size() <= 9) {
+            const QuadraticForm<R> form(coefficients);
+            const real d = 2.0 / size;
+            for (auto &item : faceTransforms()) {
+                PixelArray<F> &face = *faces[item.first];
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        const vec3 r = item.second * normalize(vec3(-1 + d * (j + 0.5), -1 + d * (i + 0.5), -1));
+                        face[i][j] = F(form(r));
+                    }
                 }
-                t += dt;
             }
-            faces[face] = bitmap;
+            return make_shared<CubeMap<F>>(
+                    faces[CubeMapFaceEnum::PositiveX],
+                    faces[CubeMapFaceEnum::NegativeX],
+                    faces[CubeMapFaceEnum::PositiveY],
+                    faces[CubeMapFaceEnum::NegativeY],
+                    faces[CubeMapFaceEnum::PositiveZ],
+                    faces[CubeMapFaceEnum::NegativeZ]);
         }
+
+        // y(k, g(d)) = sign * y(index, d), so value at g(d) is decoded from coefficients moved by the group element
+        const auto n = sh::order(coefficients);
+        const symmetry::BasisAction action(n);
+        vector<ShCoefficients<R>> moved(symmetry::ELEMENTS, ShCoefficients<R>(coefficients.size(), R(0)));
+        for (uint8_t element = 0; element < symmetry::ELEMENTS; element++) {
+            for (size_t k = 0; k < coefficients.size(); k++) {
+                moved[element][action.index(element, k)] = coefficients[k] * action.sign(element, k);
+            }
+        }
+
+        shared_ptr<const TexelBasis> basis;
+        if (TexelBasis::affordable((uint16_t) size, (uint16_t) n)) {
+            basis = TexelBasis::get((uint16_t) size, (uint16_t) n);
+        }
+
+        vector<real> center(coefficients.size());
+        size_t index = 0;
+        symmetry::orbits(size, [&](const symmetry::Orbit &orbit) {
+            const real *y = center.data();
+            if (basis) {
+                y = (*basis)(index++);
+            } else {
+                math::basis(n, orbit.direction, center.data());
+            }
+            for (uint8_t k = 0; k < orbit.size; k++) {
+                const symmetry::Texel &texel = orbit.images[k].texel;
+                const ShCoefficients<R> &c = moved[orbit.images[k].element];
+                R v(0);
+                for (size_t i = 0; i < c.size(); i++) {
+                    v += c[i] * y[i];
+                }
+                (*faces[texel.face])[texel.i][texel.j] = F(v);
+            }
+        });
         return make_shared<CubeMap<F>>(
                 faces[CubeMapFaceEnum::PositiveX],
                 faces[CubeMapFaceEnum::NegativeX],
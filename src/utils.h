@@ -21,6 +21,10 @@
 #include "pixel_format.h"
 #include "CubeMap.h"
 #include "spherical_harmonic.h"
+#include "PlanarCoefficients.h"
+#include "MultiChannelCubeMap.h"
+#include "ColorSpace.h"
+#include "Hemisphere.h"
 
 namespace sh {
     using namespace std;
@@ -90,6 +94,73 @@ namespace sh {
         return make_shared<CubeMap<RGBAF>>(pxBmp, nxBmp, pyBmp, nyBmp, pzBmp, nzBmp);
     }
 
+    /**
+     * Face names used in file names of cubemap images, in CubeMapFaceEnum order
+     */
+    const vector<string> &faceNames() {
+        static const vector<string> names = {"posx"s, "negx"s, "posy"s, "negy"s, "posz"s, "negz"s};
+        return names;
+    }
+
+    /**
+     * Load cubemap of any amount of channels stacked from layers of images. Every layer is a path pattern where
+     * '{face}' stands for posx, negx, posy, negy, posz, negz; all channels of its images are taken, layer after layer
+     * @param layers
+     * @return
+     */
+    MultiChannelCubeMap loadCubemapLayers(const vector<string> &layers) {
+        struct Layer {
+            float *faces[6];
+            int channels;
+        };
+        // images already loaded are freed when loading of the rest throws
+        vector<unique_ptr<float, void (*)(void *)>> images;
+        vector<Layer> loaded;
+        int size = 0, total = 0;
+        stbi_set_flip_vertically_on_load(1);
+        for (auto &pattern : layers) {
+            Layer layer{};
+            for (int face = 0; face < 6; face++) {
+                string path = pattern;
+                const auto at = path.find("{face}"s);
+                if (at == string::npos) {
+                    throw runtime_error("Layer '" + pattern + "' has no {face} placeholder");
+                }
+                path.replace(at, 6, faceNames()[face]);
+                int width, height, channels;
+                layer.faces[face] = stbi_loadf(path.c_str(), &width, &height, &channels, 0);
+                if (!layer.faces[face]) {
+                    throw runtime_error("Failed to load image '" + path + "' due to reason: " + stbi_failure_reason());
+                }
+                images.emplace_back(layer.faces[face], stbi_image_free);
+                if (width != height || (size && width != size) || (face && channels != layer.channels)) {
+                    throw runtime_error("Image '" + path + "' doesn't match the other faces");
+                }
+                size = width;
+                layer.channels = channels;
+            }
+            total += layer.channels;
+            loaded.push_back(layer);
+        }
+
+        MultiChannelCubeMap cubemap(size, (uint16_t) total);
+        int offset = 0;
+        size_t image = 0;
+        for (auto &layer : loaded) {
+            for (int face = 0; face < 6; face++) {
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        const float *in = layer.faces[face] + ((size_t) i * size + j) * layer.channels;
+                        std::copy(in, in + layer.channels, cubemap.texel((CubeMapFaceEnum) face, i, j) + offset);
+                    }
+                }
+                images[image++].reset();
+            }
+            offset += layer.channels;
+        }
+        return cubemap;
+    }
+
     std::ostream &operator<<(std::ostream &stream, const ShCoefficients<RGB> &h) {
 
         stream << "{" << std::endl;
@@ -174,6 +245,114 @@ namespace sh {
         f.close();
     }
 
+    /**
+     * Write coefficients of any amount of channels in the same format as color ones
+     * @param path
+     * @param coefficients
+     * @param names channel names, missing names are 'channel<index>'
+     */
+    void write(const std::string &path, const PlanarCoefficients &coefficients, const std::vector<std::string> &names) {
+        std::ofstream f;
+        f.open(path);
+        f << "{" << std::endl;
+        f << "\t\"order\": " << coefficients.getOrder() << ", " << std::endl;
+        f << "\t\"channels\": {" << std::endl;
+        for (uint16_t c = 0; c < coefficients.getChannels(); c++) {
+            const string name = c < names.size() ? names[c] : "channel"s + to_string(c);
+            f << "\t\t\"" << name << "\": [";
+            for (size_t k = 0; k < coefficients.size(); k++) {
+                if (k > 0) {
+                    f << ", ";
+                }
+                f << coefficients(c, k);
+            }
+            f << "]" << (c + 1u < coefficients.getChannels() ? "," : "") << std::endl;
+        }
+        f << "\t}" << std::endl;
+        f << "}";
+        f.close();
+    }
+
+    /**
+     * Channel names of color space in the order of ColorCoefficients
+     * @param space
+     * @return
+     */
+    const vector<string> &channelNames(ColorSpace space) {
+        static const vector<string> rgb = {"red"s, "green"s, "blue"s};
+        static const vector<string> ycocg = {"y"s, "co"s, "cg"s};
+        return space == ColorSpace::YCoCg ? ycocg : rgb;
+    }
+
+    /**
+     * Write color coefficients of given basis, Hemispherical Harmonics are marked with "basis": "hsh" so they are not
+     * taken for spherical harmonics
+     * @param path
+     * @param coefficients
+     * @param basis
+     */
+    void write(const std::string &path, const ShCoefficients<RGB> &coefficients, Basis basis) {
+        if (basis == Basis::Spherical) {
+            write(path, coefficients);
+            return;
+        }
+        const auto &names = channelNames(ColorSpace::Rgb);
+        std::ofstream f;
+        f.open(path);
+        f << "{" << std::endl;
+        f << "\t\"order\": " << order(coefficients) << ", " << std::endl;
+        f << "\t\"basis\": \"hsh\", " << std::endl;
+        f << "\t\"channels\": {" << std::endl;
+        for (size_t c = 0; c < 3; c++) {
+            f << "\t\t\"" << names[c] << "\": [";
+            for (size_t k = 0; k < coefficients.size(); k++) {
+                if (k > 0) {
+                    f << ", ";
+                }
+                f << (c == 0 ? coefficients[k].r : c == 1 ? coefficients[k].g : coefficients[k].b);
+            }
+            f << "]" << (c < 2 ? "," : "") << std::endl;
+        }
+        f << "\t}" << std::endl;
+        f << "}";
+        f.close();
+    }
+
+    /**
+     * Write color coefficients channel by channel, every channel has as many values as its order needs. Orders of
+     * channels are written along
+     * @param path
+     * @param coefficients
+     */
+    void write(const std::string &path, const ColorCoefficients &coefficients) {
+        const auto &names = channelNames(coefficients.space);
+        std::ofstream f;
+        f.open(path);
+        f << "{" << std::endl;
+        f << "\t\"order\": " << coefficients.getOrder() << ", " << std::endl;
+        f << "\t\"space\": \"" << (coefficients.space == ColorSpace::YCoCg ? "ycocg" : "rgb") << "\", " << std::endl;
+        f << "\t\"orders\": {";
+        for (size_t c = 0; c < 3; c++) {
+            f << "\"" << names[c] << "\": " << order(coefficients.channels[c]) << (c < 2 ? ", " : "");
+        }
+        f << "}, " << std::endl;
+        f << "\t\"channels\": {" << std::endl;
+        for (size_t c = 0; c < 3; c++) {
+            const auto &channel = coefficients.channels[c];
+            f << "\t\t\"" << names[c] << "\": [";
+            for (size_t k = 0; k < channel.size(); k++) {
+                if (k > 0) {
+                    f << ", ";
+                }
+                f << channel[k];
+            }
+            f << "]" << (c < 2 ? "," : "") << std::endl;
+        }
+        f << "\t}" << std::endl;
+        f << "}";
+        f.close();
+    }
+
     inline stbi_uc *hdr2ldr(const PixelArray<RGBF> &bitmap) {
         const auto w = bitmap.getWidth(), h = bitmap.getHeight();
         const auto bytes = sizeof(RGBF) * w * h;
@@ -304,7 +483,69 @@ namespace sh {
     };
 
 
-    static map<string, vector<float>> _read(const string &path) {
+    /**
+     * Write every channel of cubemap as single channel images named '<prefix><channel name>-<face>'
+     * @param path destination folder
+     * @param format
+     * @param cubemap
+     * @param names channel names, missing names are 'channel<index>'
+     * @param prefix
+     */
+    void write(const std::string &path, const FileFormat format, const MultiChannelCubeMap &cubemap,
+            const std::vector<std::string> &names, const std::string &prefix = "") {
+        using namespace std;
+        stbi_flip_vertically_on_write(1);
+        const map<FileFormat, string> extensions = {
+                {FileFormat::Png, "png"s},
+                {FileFormat::Bmp, "bmp"s},
+                {FileFormat::Tga, "tga"s},
+                {FileFormat::Jpg, "jpg"s},
+                {FileFormat::Hdr, "hdr"s}
+        };
+
+        const int size = cubemap.getSize();
+        vector<float> plane((size_t) size * size);
+        for (uint16_t c = 0; c < cubemap.getChannels(); c++) {
+            const string name = c < names.size() ? names[c] : "channel"s + to_string(c);
+            for (int face = 0; face < 6; face++) {
+                for (int i = 0; i < size; i++) {
+                    for (int j = 0; j < size; j++) {
+                        plane[(size_t) i * size + j] = cubemap.texel((CubeMapFaceEnum) face, i, j)[c];
+                    }
+                }
+                const auto filename = path + "/"s + prefix + name + "-"s + faceNames()[face] + "."s +
+                                      extensions.at(format);
+                int written;
+                if (format == FileFormat::Hdr) {
+                    written = stbi_write_hdr(filename.c_str(), size, size, 1, plane.data());
+                } else {
+                    auto *data = (float *) STBI_MALLOC(plane.size() * sizeof(float));
+                    memcpy(data, plane.data(), plane.size() * sizeof(float));
+                    stbi_uc *ldr = stbi__hdr_to_ldr(data, size, size, 1);
+                    if (format == FileFormat::Png) {
+                        written = stbi_write_png(filename.c_str(), size, size, 1, ldr, 0);
+                    } else if (format == FileFormat::Bmp) {
+                        written = stbi_write_bmp(filename.c_str(), size, size, 1, ldr);
+                    } else if (format == FileFormat::Tga) {
+                        written = stbi_write_tga(filename.c_str(), size, size, 1, ldr);
+                    } else {
+                        written = stbi_write_jpg(filename.c_str(), size, size, 1, ldr, 95);
+                    }
+                    STBI_FREE(ldr);
+                }
+                if (!written) {
+                    throw runtime_error("Failed to write to file: '" + filename + "'");
+                }
+            }
+        }
+    }
+
+    /**
+     * Channels of encoded data in the order of the file
+     * @param path
+     * @return
+     */
+    static vector<pair<string, vector<float>>> _readOrdered(const string &path) {
         using namespace std;
         ifstream f(path);
 
@@ -316,9 +557,12 @@ namespace sh {
 
 
         json_value_s *root = json_parse(str.c_str(), str.length());
+        if (!root) {
+            throw runtime_error("Failed to parse file: '" + path + "'");
+        }
         auto *object = (json_object_s *) root->payload;
 
-        map<string, vector<float>> channelsMap;
+        vector<pair<string, vector<float>>> channelsList;
         for (auto *element = object->start; element; element = element->next) {
             const string name = element->name->string;
             json_value_s *value = element->value;
@@ -329,21 +573,93 @@ namespace sh {
                     const string channelName = channel->name->string;
                     json_value_s *value = channel->value;
 
+                    channelsList.emplace_back(channelName, vector<float>());
                     auto *coeffArray = (json_array_s *) value->payload;
                     for (auto *coeff = coeffArray->start; coeff; coeff = coeff->next) {
                         auto *coeffValue = (json_number_s *) coeff->value->payload;
                         const string coeffStr = coeffValue->number;
                         float coeffVal = stof(coeffStr);
-                        channelsMap[channelName].push_back(coeffVal);
+                        channelsList.back().second.push_back(coeffVal);
                     }
                 }
             }
         }
         free(root);
+        return channelsList;
+    }
+
+    /**
+     * Basis of encoded data told by its "basis" field, data without one is spherical harmonics
+     * @param path
+     * @return
+     */
+    Basis readBasis(const string &path) {
+        ifstream f(path);
+        if (!f) {
+            throw runtime_error("Failed to open file: '" + path + "'");
+        }
+        string str((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        json_value_s *root = json_parse(str.c_str(), str.length());
+        if (!root) {
+            throw runtime_error("Failed to parse file: '" + path + "'");
+        }
+        auto *object = (json_object_s *) root->payload;
+        string basis = "sh"s;
+        for (auto *element = object->start; element; element = element->next) {
+            if (element->name->string == "basis"s && element->value->type == json_type_string) {
+                basis = ((json_string_s *) element->value->payload)->string;
+            }
+        }
+        free(root);
+        if (basis == "hsh"s) {
+            return Basis::Hemispherical;
+        } else if (basis != "sh"s) {
+            throw runtime_error("Unknown basis '" + basis + "' in file: '" + path + "'");
+        }
+        return Basis::Spherical;
+    }
+
+    /**
+     * Refuse Hemispherical Harmonics where spherical harmonics are read, they decode into garbage as such
+     * @param path
+     */
+    static void _expectSpherical(const string &path) {
+        if (readBasis(path) != Basis::Spherical) {
+            throw runtime_error("File holds hemispherical harmonics, not spherical harmonics: '" + path + "'");
+        }
+    }
+
+    static map<string, vector<float>> _read(const string &path) {
+        map<string, vector<float>> channelsMap;
+        for (auto &channel : _readOrdered(path)) {
+            channelsMap[channel.first] = channel.second;
+        }
         return channelsMap;
     }
 
-    ShCoefficients<RGB> readRgb(const std::string &path) {
+    /**
+     * Read color coefficients channel by channel, color space is told by channel names (red, green, blue or y, co, cg)
+     * and order of every channel by its amount of values
+     * @param path
+     * @return
+     */
+    ColorCoefficients readColor(const std::string &path) {
+        _expectSpherical(path);
+        auto channels = _read(path);
+        ColorCoefficients coefficients;
+        coefficients.space = channels.count("y"s) ? ColorSpace::YCoCg : ColorSpace::Rgb;
+        const auto &names = channelNames(coefficients.space);
+        for (size_t c = 0; c < 3; c++) {
+            const auto channel = channels.find(names[c]);
+            if (channel == channels.end()) {
+                throw runtime_error("Channel '" + names[c] + "' is missing in file: '" + path + "'");
+            }
+            coefficients.channels[c].assign(channel->second.begin(), channel->second.end());
+        }
+        return coefficients;
+    }
+
+    static ShCoefficients<RGB> _readRgb(const std::string &path) {
         using namespace std;
 
         auto channels = _read(path);
@@ -353,6 +669,12 @@ namespace sh {
             return coefficients;
         }
 
+        // channels of own orders or of other color space
+        if (channels.count("y"s) || channels["red"s].size() != channels["green"s].size() ||
+            channels["red"s].size() != channels["blue"s].size()) {
+            return combine(readColor(path));
+        }
+
         const auto size = channels.begin()->second.size();
         coefficients.resize(size);
 
@@ -375,9 +697,24 @@ namespace sh {
         return coefficients;
     }
 
+    ShCoefficients<RGB> readRgb(const std::string &path) {
+        _expectSpherical(path);
+        return _readRgb(path);
+    }
+
+    /**
+     * Read color coefficients of Hemispherical Harmonics, files without "basis" field are taken as they are
+     * @param path
+     * @return
+     */
+    ShCoefficients<RGB> readHemispherical(const std::string &path) {
+        return _readRgb(path);
+    }
+
     ShCoefficients<RGBA> readRgba(const std::string &path) {
         using namespace std;
 
+        _expectSpherical(path);
         auto channels = _read(path);
         ShCoefficients<RGBA> coefficients;
 
@@ -407,5 +744,94 @@ namespace sh {
         }
         return coefficients;
     }
+
+    /**
+     * Read coefficients of any amount of channels
+     * @param path
+     * @param names receives channel names in the order of the file
+     * @return
+     */
+    PlanarCoefficients readPlanar(const std::string &path, std::vector<std::string> &names) {
+        const auto channels = _readOrdered(path);
+        names.clear();
+        if (channels.empty()) {
+            return PlanarCoefficients();
+        }
+        PlanarCoefficients coefficients((uint16_t) channels.size(), order(channels.front().second));
+        for (uint16_t c = 0; c < channels.size(); c++) {
+            names.push_back(channels[c].first);
+            const auto &values = channels[c].second;
+            for (size_t k = 0; k < coefficients.size() && k < values.size(); k++) {
+                coefficients(c, k) = values[k];
+            }
+        }
+        return coefficients;
+    }
+
+    /**
+     * Read unit directions stored as consecutive float32 (x, y, z) triples
+     * @param path
+     * @return
+     */
+    std::vector<vec3> readDirections(const std::string &path) {
+        using namespace std;
+        ifstream f(path, ios::binary);
+        if (!f) {
+            throw runtime_error("Failed to open file: '" + path + "'");
+        }
+        f.seekg(0, ios::end);
+        const auto bytes = f.tellg();
+        if (bytes < 0 || (size_t) bytes % (3 * sizeof(float))) {
+            throw runtime_error("File size is not a multiple of (x, y, z) float32 triples: '" + path + "'");
+        }
+        const size_t count = (size_t) bytes / (3 * sizeof(float));
+        f.seekg(0, ios::beg);
+
+        vector<float> triples(count * 3);
+        if (!f.read((char *) triples.data(), triples.size() * sizeof(float))) {
+            throw runtime_error("Failed to read directions from file: '" + path + "'");
+        }
+        vector<vec3> directions(count);
+        for (size_t i = 0; i < count; i++) {
+            directions[i] = vec3(triples[i * 3], triples[i * 3 + 1], triples[i * 3 + 2]);
+        }
+        return directions;
+    }
+
+    /**
+     * Write values as consecutive float32 (r, g, b) triples
+     * @param path
+     * @param values
+     */
+    void writeBinary(const std::string &path, const std::vector<RGB> &values) {
+        using namespace std;
+        vector<float> data;
+        data.reserve(values.size() * 3);
+        for (auto &value : values) {
+            data.insert(data.end(), {(float) value.r, (float) value.g, (float) value.b});
+        }
+        ofstream f(path, ios::binary);
+        if (!f.write((const char *) data.data(), data.size() * sizeof(float))) {
+            throw runtime_error("Failed to write to file: '" + path + "'");
+        }
+    }
+
+    /**
+     * Write values as consecutive float32 (r, g, b, a) quadruples
+     * @param path
+     * @param values
+     */
+    void writeBinary(const std::string &path, const std::vector<RGBA> &values) {
+        using namespace std;
+        vector<float> data;
+        data.reserve(values.size() * 4);
+        for (auto &value : values) {
+            data.insert(data.end(), {(float) value.r, (float) value.g, (float) value.b, (float) value.a});
+        }
+        ofstream f(path, ios::binary);
+        if (!f.write((const char *) data.data(), data.size() * sizeof(float))) {
+            throw runtime_error("Failed to write to file: '" + path + "'");
+        }
+    }
 }
 #endif //SH_UTILS_H